@@ -23,6 +23,7 @@
 #include <future>
 #include <memory>
 #include <cstdint>
+#include <array>
 
 class BinModel  {
 public:
@@ -36,8 +37,10 @@ public:
     static const uint32_t N_BIN = 256;
     static const uint32_t N_COL = 3;
     static constexpr auto EXP_BITS_PER_SAMPLE{8};
+    static constexpr size_t PARALLEL_ROWS{64u};
     bool isZero();
 protected:
+    using Bins = std::array<std::array<uint32_t, N_COL>, N_BIN>;
 
 private:
     Glib::Dispatcher& m_binDispatcher;
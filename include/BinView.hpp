@@ -26,6 +26,7 @@
 #include <cstdint>
 
 #include "BinModel.hpp"
+#include "Executor.hpp"
 
 class DisplayImage;
 
@@ -47,6 +48,7 @@ private:
     Glib::Dispatcher m_binDispatcher;
     std::future<void> m_pixelReader;
     std::shared_ptr<BinModel> m_model;
+    psc::util::TaskGroup m_reads;           // keep last, the reads use our dispatcher
 
     static const int32_t m_base = 16;
     static const int32_t m_weightWidth = 96;
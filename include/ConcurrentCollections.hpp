@@ -27,6 +27,19 @@
 #include <thread>
 #include <future>
 #include <algorithm>
+#include <cstdint>
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <array>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <atomic>
+#include <bit>
+#include <memory>
+
+#include "Parallel.hpp"
 
 
 // adapted from
@@ -36,6 +49,8 @@
             pop_front() waits for the notification of a filling method if the collection is empty.
             The various "emplace" operations are factorized by using the generic "addData_protected".
             This generic asks for a concrete operation to use, which can be passed as a lambda.
+            With a capacity the adding operations wait while the queue is full,
+            this way the memory used by a pipeline is bounded.
 **/
 template< typename T >
 class TQueueConcurrent {
@@ -43,39 +58,75 @@ class TQueueConcurrent {
     using const_iterator = typename std::deque<T>::const_iterator;
 
 public:
+    static constexpr size_t UNBOUNDED{std::numeric_limits<size_t>::max()};
 
-    TQueueConcurrent()
+    explicit TQueueConcurrent(size_t capacity = UNBOUNDED)
     : _active(true)
+    , _capacity{std::max(static_cast<size_t>(1u), capacity)}
     {
 
     }
 
-    //! @brief Emplaces a new instance of T in front of the deque
+    //! @brief Emplaces a new instance of T in front of the deque, false if finished
     template<typename... Args>
-    void emplace_front( Args&&... args )
+    bool emplace_front( Args&&... args )
     {
-        addData_protected( [&] {
+        return addData_protected( [&] {
             _collection.emplace_front(std::forward<Args>(args)...);
         } );
     }
 
-    /** @brief Emplaces a new instance of T at the back of the deque **/
+    /** @brief Emplaces a new instance of T at the back of the deque, false if finished **/
     template<typename... Args>
-    void emplace_back( Args&&... args )
+    bool emplace_back( Args&&... args )
     {
-        addData_protected( [&] {
+        return addData_protected( [&] {
             _collection.emplace_back(std::forward<Args>(args)...);
         } );
     }
 
     template<typename... Args>
-    void push_back( Args&&... args )
+    bool push_back( Args&&... args )
     {
-        addData_protected( [&] {
+        return addData_protected( [&] {
             _collection.push_back(std::forward<Args>(args)...);
         } );
     }
 
+    /** @brief  Adds at the back, waits while the queue is full.
+                Returns false if the queue was finished (the value is dropped).
+    **/
+    bool push( T value )
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        _condSpace.wait(lock, [this] {
+            return !_active || _collection.size() < _capacity;
+        });
+        if (!_active) {
+            return false;
+        }
+        _collection.push_back(std::move(value));
+        lock.unlock();
+        _condNewData.notify_one();
+        return true;
+    }
+
+    /** @brief  Adds at the back if there is room.
+                Returns false if the queue is full or finished.
+    **/
+    bool try_push( T value )
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        if (!_active
+         || _collection.size() >= _capacity) {
+            return false;
+        }
+        _collection.push_back(std::move(value));
+        lock.unlock();
+        _condNewData.notify_one();
+        return true;
+    }
+
     /** @brief  Returns the front element and removes it from the collection
                 No exception is ever returned as we garanty that the deque is not empty
                 before trying to return data.
@@ -92,32 +143,104 @@ public:
         }
         auto elem = std::move(_collection.front());
         _collection.pop_front();
+        lock.unlock();
+        _condSpace.notify_one();
+        return elem;
+    }
+
+    /** @brief  Returns the front element, waits up to timeout if empty.
+                Unlike pop_front the remaining elements are returned after finish,
+                the result is empty on timeout or if finished and drained.
+    **/
+    template< typename Rep, typename Period >
+    std::optional<T> pop_for( const std::chrono::duration<Rep, Period>& timeout )
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        if (!_condNewData.wait_for(lock, timeout, [this] {
+                return !_collection.empty() || !_active;
+            })
+         || _collection.empty()) {
+            return std::nullopt;
+        }
+        std::optional<T> elem{std::move(_collection.front())};
+        _collection.pop_front();
+        lock.unlock();
+        _condSpace.notify_one();
         return elem;
     }
 
+    /** @brief  Returns up to n elements, waits for at least one.
+                The result is empty if finished and drained.
+    **/
+    std::vector<T> pop_batch( size_t n )
+    {
+        std::vector<T> batch;
+        std::unique_lock<std::mutex> lock{_mutex};
+        _condNewData.wait(lock, [this] {
+            return !_collection.empty() || !_active;
+        });
+        auto count = std::min(n, _collection.size());
+        batch.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            batch.emplace_back(std::move(_collection.front()));
+            _collection.pop_front();
+        }
+        lock.unlock();
+        if (count > 0) {
+            _condSpace.notify_all();
+        }
+        return batch;
+    }
+
+    /** @brief  Ends the queue, any following add is rejected.
+                Waiting consumers and producers are woken, several may wait on the same queue.
+    **/
     void finish( void )
     {
+        std::unique_lock<std::mutex> lock{_mutex};
         _active = false;
-        _condNewData.notify_one();
+        lock.unlock();
+        _condNewData.notify_all();
+        _condSpace.notify_all();
     }
 
     bool isActive( void )
     {
+        std::lock_guard<std::mutex> lock{_mutex};
         return _active;
     }
+
+    size_t size( void )
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        return _collection.size();
+    }
+
+    size_t capacity( void ) const
+    {
+        return _capacity;
+    }
 private:
 
     /** @brief  Protects the deque, calls the provided function and notifies the presence of new data
         @param  The concrete operation to be used. It MUST be an operation which will add data to the deque,
                 as it will notify that new data are available!
+        @return false if the queue was finished, the data is not added (same as push)
     **/
     template<class F>
-    void addData_protected(F&& fct)
+    bool addData_protected(F&& fct)
     {
         std::unique_lock<std::mutex> lock{ _mutex };
+        _condSpace.wait(lock, [this] {
+            return !_active || _collection.size() < _capacity;
+        });
+        if (!_active) {
+            return false;
+        }
         fct();
         lock.unlock();
         _condNewData.notify_one();
+        return true;
     }
 
     std::deque<T> _collection;              ///< Concrete, not thread safe, storage.
@@ -126,7 +249,11 @@ private:
 
     std::condition_variable _condNewData;   ///< Condition used to notify that new data are available.
 
+    std::condition_variable _condSpace;     ///< Condition used to notify that there is room.
+
     bool _active;
+
+    const size_t _capacity;
 };
 
 template< typename T >
@@ -143,9 +270,9 @@ public:
 
     /** @brief Emplaces a new instance of T at the back of the list **/
     template<typename... Args>
-    void push_back( Args&&... args )
+    bool push_back( Args&&... args )
     {
-        addData_protected( [&] {
+        return addData_protected( [&] {
             _collection.push_back(std::forward<Args>(args)...);
         } );
     }
@@ -183,6 +310,7 @@ private:
 
 };
 
+// for concurrent lookups prefer TShardedMapConcurrent
 template< typename K, typename T >
 class TMapConcurrent {
 
@@ -231,6 +359,7 @@ public:
 
     bool empty( void )
     {
+        std::unique_lock<std::mutex> lock{_mutex};
         return _collection.empty();
     }
 private:
@@ -251,8 +380,398 @@ private:
 
 };
 
+/** @brief  A templated *thread-safe* hash map, split into shards with a reader/writer lock each.
+            Lookups run concurrently, a modification only blocks the shard of its key.
+            Values are returned as copies, use shared_ptr for larger ones.
+**/
+template< typename K, typename T, typename Hash = std::hash<K>, size_t Shards = 16u >
+class TShardedMapConcurrent {
+
+    static_assert(Shards >= 1u && (Shards & (Shards - 1u)) == 0u, "Shards has to be a power of 2");
+
+public:
+
+    TShardedMapConcurrent() = default;
+    explicit TShardedMapConcurrent(const TShardedMapConcurrent& orig) = delete;
+
+    /** @brief  get a copy of the entry, empty if there is none
+    **/
+    std::optional<T> find( const K& k ) const
+    {
+        auto& shard = getShard(k);
+        std::shared_lock<std::shared_mutex> lock{shard._mutex};
+        auto p = shard._collection.find(k);
+        if (p == shard._collection.end()) {
+            return std::nullopt;
+        }
+        return p->second;
+    }
+
+    bool contains( const K& k ) const
+    {
+        auto& shard = getShard(k);
+        std::shared_lock<std::shared_mutex> lock{shard._mutex};
+        return shard._collection.find(k) != shard._collection.end();
+    }
+
+    /** @brief  put the entry into the map,
+                returns true if it was inserted, false if it was assigned.
+    **/
+    template< typename V >
+    bool insert_or_assign( const K& k, V&& v )
+    {
+        auto& shard = getShard(k);
+        std::unique_lock<std::shared_mutex> lock{shard._mutex};
+        return shard._collection.insert_or_assign(k, std::forward<V>(v)).second;
+    }
+
+    /** @brief  get the entry, if there is none it is created with fun(k).
+                fun is called once per key even if many ask for it at the same time,
+                but as it runs with the shard locked keep it short
+                (for a lengthy fill use e.g. a std::shared_future as value).
+    **/
+    template< typename F >
+    T compute_if_absent( const K& k, F&& fun )
+    {
+        auto& shard = getShard(k);
+        {
+            std::shared_lock<std::shared_mutex> lock{shard._mutex};
+            auto p = shard._collection.find(k);
+            if (p != shard._collection.end()) {
+                return p->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock{shard._mutex};
+        auto p = shard._collection.find(k);     // someone may have been faster
+        if (p == shard._collection.end()) {
+            p = shard._collection.emplace(k, fun(k)).first;
+        }
+        return p->second;
+    }
+
+    /** @brief remove from map
+    **/
+    bool erase( const K& k )
+    {
+        auto& shard = getShard(k);
+        std::unique_lock<std::shared_mutex> lock{shard._mutex};
+        return shard._collection.erase(k) > 0u;
+    }
+
+    /** @brief  remove the entries for which pred(key, value) is true,
+                returns the number of removed entries.
+    **/
+    template< typename P >
+    size_t erase_if( P pred )
+    {
+        size_t count{};
+        for (auto& shard : _shards) {
+            std::unique_lock<std::shared_mutex> lock{shard._mutex};
+            count += std::erase_if(shard._collection, [&pred] (const auto& entry) {
+                return pred(entry.first, entry.second);
+            });
+        }
+        return count;
+    }
+
+    /** @brief  calls fun(key, value) for each entry, the shard is locked shared meanwhile,
+                so fun shall not modify this map.
+    **/
+    template< typename F >
+    void for_each( F fun ) const
+    {
+        for (auto& shard : _shards) {
+            std::shared_lock<std::shared_mutex> lock{shard._mutex};
+            for (auto& entry : shard._collection) {
+                fun(entry.first, entry.second);
+            }
+        }
+    }
+
+    void clear( void )
+    {
+        for (auto& shard : _shards) {
+            std::unique_lock<std::shared_mutex> lock{shard._mutex};
+            shard._collection.clear();
+        }
+    }
+
+    /** @brief  as others may modify meanwhile, this is only a estimate
+    **/
+    size_t size( void ) const
+    {
+        size_t count{};
+        for (auto& shard : _shards) {
+            std::shared_lock<std::shared_mutex> lock{shard._mutex};
+            count += shard._collection.size();
+        }
+        return count;
+    }
+
+    bool empty( void ) const
+    {
+        return size() == 0u;
+    }
+
+private:
+    struct alignas(64) Shard {      // avoid sharing cache lines between shards
+        mutable std::shared_mutex _mutex;
+        std::unordered_map<K, T, Hash> _collection;
+    };
+
+    const Shard& getShard( const K& k ) const
+    {
+        return _shards[getShardIndex(k)];
+    }
+
+    Shard& getShard( const K& k )
+    {
+        return _shards[getShardIndex(k)];
+    }
+
+    size_t getShardIndex( const K& k ) const
+    {
+        // spread the bits as std::hash is identity for integers
+        auto h = static_cast<uint64_t>(Hash{}(k)) * 0x9e3779b97f4a7c15ull;
+        return static_cast<size_t>(h >> 32) & (Shards - 1u);
+    }
+
+    std::array<Shard, Shards> _shards;
+
+};
+
+/** @brief  A templated *thread-safe* append only vector, the elements keep their address.
+            Readers do not wait for the writers, they see the elements up to the size at the time
+            they asked (use snapshot to iterate, e.g. while workers still append).
+            The current table is shared by a std::atomic<std::shared_ptr>,
+            with libstdc++ this is not lock-free (a short internal lock on each load).
+            The writing operations are serialized, sort and clear publish
+            a new snapshot and leave the existing to their readers.
+            T has to be default constructible.
+**/
+template< typename T >
+class TSegmentedVectorConcurrent {
+
+    static constexpr size_t BASE_BITS{6u};
+    static constexpr size_t BASE{static_cast<size_t>(1u) << BASE_BITS};
+    static constexpr size_t MAX_SEGMENTS{40u};      // segments grow by 2, this is plenty
+
+    // segment k starts at BASE * (2^k - 1) and has BASE * 2^k elements
+    struct Table {
+        std::array<std::unique_ptr<T[]>, MAX_SEGMENTS> _segments;
+        std::atomic<size_t> _size{0u};      // published, the elements before are complete
+
+        static void locate( size_t index, size_t& segment, size_t& offset )
+        {
+            segment = std::bit_width((index >> BASE_BITS) + 1u) - 1u;
+            offset = index - BASE * ((static_cast<size_t>(1u) << segment) - 1u);
+        }
+        T& at( size_t index ) const
+        {
+            size_t segment, offset;
+            locate(index, segment, offset);
+            return _segments[segment][offset];
+        }
+        // only for the writer, and before publishing the size
+        void reserve( size_t size )
+        {
+            if (size == 0u) {
+                return;
+            }
+            size_t last, offset;
+            locate(size - 1u, last, offset);
+            for (size_t segment = 0; segment <= last; ++segment) {
+                if (!_segments[segment]) {
+                    _segments[segment] = std::make_unique<T[]>(BASE << segment);
+                }
+            }
+        }
+    };
+
+public:
+
+    /** @brief  a consistent view, stays valid while others append, sort or clear
+    **/
+    class Snapshot {
+    public:
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const T*;
+            using reference         = const T&;
+
+            const_iterator( const Table* table, size_t index )
+            : _table{table}
+            , _index{index}
+            {
+            }
+            reference operator*() const
+            {
+                return _table->at(_index);
+            }
+            pointer operator->() const
+            {
+                return &_table->at(_index);
+            }
+            const_iterator& operator++()
+            {
+                ++_index;
+                return *this;
+            }
+            const_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++_index;
+                return tmp;
+            }
+            bool operator==( const const_iterator& other ) const
+            {
+                return _index == other._index;
+            }
+        private:
+            const Table* _table;
+            size_t _index;
+        };
+
+        Snapshot( const std::shared_ptr<const Table>& table )
+        : _table{table}
+        , _size{table->_size.load(std::memory_order_acquire)}
+        {
+        }
+        size_t size( void ) const
+        {
+            return _size;
+        }
+        bool empty( void ) const
+        {
+            return _size == 0u;
+        }
+        const T& operator[]( size_t index ) const
+        {
+            return _table->at(index);
+        }
+        const_iterator begin( void ) const
+        {
+            return const_iterator(_table.get(), 0u);
+        }
+        const_iterator end( void ) const
+        {
+            return const_iterator(_table.get(), _size);
+        }
+    private:
+        std::shared_ptr<const Table> _table;
+        size_t _size;
+    };
+
+    TSegmentedVectorConcurrent()
+    : _table{std::make_shared<Table>()}
+    {
+        _current.store(_table, std::memory_order_release);
+    }
+    explicit TSegmentedVectorConcurrent(const TSegmentedVectorConcurrent& orig) = delete;
+
+    Snapshot snapshot( void ) const
+    {
+        return Snapshot(_current.load(std::memory_order_acquire));
+    }
+
+    size_t size( void ) const
+    {
+        return _current.load(std::memory_order_acquire)->_size.load(std::memory_order_acquire);
+    }
+
+    /** @brief  get a copy of a entry (index < size),
+                a reference would dangle if a concurrent clear or sort releases the table,
+                use a snapshot to access the entries without copying
+    **/
+    T operator[]( size_t index ) const
+    {
+        auto table = _current.load(std::memory_order_acquire);
+        return table->at(index);
+    }
+
+    void push_back( const T& value )
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        auto size = _table->_size.load(std::memory_order_relaxed);
+        _table->reserve(size + 1u);
+        _table->at(size) = value;
+        _table->_size.store(size + 1u, std::memory_order_release);
+    }
+
+    void push_back( T&& value )
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        auto size = _table->_size.load(std::memory_order_relaxed);
+        _table->reserve(size + 1u);
+        _table->at(size) = std::move(value);
+        _table->_size.store(size + 1u, std::memory_order_release);
+    }
+
+    /** @brief  add the range, readers will see it all at once
+    **/
+    template< typename It >
+    void append( It first, It last )
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        auto size = _table->_size.load(std::memory_order_relaxed);
+        auto count = static_cast<size_t>(std::distance(first, last));
+        _table->reserve(size + count);
+        for (auto index = size; first != last; ++first, ++index) {
+            _table->at(index) = *first;
+        }
+        _table->_size.store(size + count, std::memory_order_release);
+    }
+
+    /** @brief  sort (in parallel) into a new snapshot
+    **/
+    template< typename S >
+    void sort( S s )
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        auto size = _table->_size.load(std::memory_order_relaxed);
+        std::vector<T> sorted;
+        sorted.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            sorted.push_back(_table->at(i));
+        }
+        psc::util::parallel_sort(sorted.begin(), sorted.end(), s);
+        auto table = std::make_shared<Table>();
+        table->reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            table->at(i) = std::move(sorted[i]);
+        }
+        table->_size.store(size, std::memory_order_release);
+        publish(table);
+    }
+
+    void clear( void )
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        publish(std::make_shared<Table>());
+    }
+
+private:
+    void publish( const std::shared_ptr<Table>& table )
+    {
+        _table = table;
+        _current.store(table, std::memory_order_release);
+    }
+
+    std::shared_ptr<Table> _table;              ///< the table for writing, protected by mutex
+
+    std::atomic<std::shared_ptr<const Table>> _current;  ///< the table for reading
+
+    std::mutex   _mutex;                        ///< Mutex serializing the writers
+
+};
+
+// operator[], size, begin and end read without the lock,
+//   so a concurrent push_back may reallocate the storage under a reader
 template< typename T >
-class TVectorConcurrent {
+class [[deprecated("use TSegmentedVectorConcurrent")]] TVectorConcurrent {
 
     using const_iterator = typename std::vector<T>::const_iterator;
 
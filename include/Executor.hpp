@@ -0,0 +1,210 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace psc::util {
+
+// the lower value is run first
+enum class Priority : uint32_t
+{
+      Visible       // the image on display
+    , Histogram
+    , Background    // default e.g. ThreadWorker
+    , Prefetch
+};
+
+struct ExecutorMetrics
+{
+    uint32_t threads{};
+    uint32_t running{};
+    size_t queued{};            // waiting now
+    size_t maxQueued{};
+    uint64_t completed{};
+    std::chrono::microseconds avgLatency{};     // from submit to start
+    std::chrono::microseconds maxLatency{};
+};
+
+class CancelledException
+: public std::runtime_error
+{
+public:
+    CancelledException()
+    : std::runtime_error("Cancelled")
+    {
+    }
+};
+
+// cooperative cancellation, the copies share the state
+//   so it may be passed on to the functions doing the work.
+class CancellationToken
+{
+public:
+    CancellationToken()
+    : m_cancelled{std::make_shared<std::atomic<bool>>(false)}
+    {
+    }
+    void cancel()
+    {
+        m_cancelled->store(true, std::memory_order_release);
+    }
+    bool isCancelled() const
+    {
+        return m_cancelled->load(std::memory_order_acquire);
+    }
+    void throwIfCancelled() const
+    {
+        if (isCancelled()) {
+            throw CancelledException();
+        }
+    }
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+// a bounded number of threads shared by the library,
+//   use this instead of std::async as each call creates a thread.
+//   Tasks must not wait for other tasks, as this may block all threads.
+class Executor
+{
+public:
+    explicit Executor(uint32_t threads = defaultThreads());
+    explicit Executor(const Executor& orig) = delete;
+    // runs the queued tasks before returning
+    virtual ~Executor();
+
+    // the library wide instance, it is intentionally never destroyed
+    //   as queued tasks may reference objects that are gone at exit,
+    //   so the tasks still queued at exit are not run
+    static Executor& get();
+    // set the number of threads for get, only effective before the first use
+    static void configure(uint32_t threads);
+    // one per core (at least 2)
+    static uint32_t defaultThreads();
+
+    template <typename F>
+    auto submit(Priority priority, F&& fun) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        // std::function requires copyable
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fun));
+        auto future = task->get_future();
+        enqueue(priority, [task] {
+            (*task)();
+        });
+        return future;
+    }
+    ExecutorMetrics getMetrics();
+    uint32_t getThreads() const;
+
+protected:
+    void enqueue(Priority priority, std::function<void()>&& fun);
+    void run();
+
+private:
+    struct Task
+    {
+        Priority priority;
+        uint64_t seq;
+        std::chrono::steady_clock::time_point submitted;
+        std::function<void()> fun;
+    };
+    struct TaskOrder
+    {
+        bool operator()(const Task& a, const Task& b) const
+        {
+            // top is the highest priority, and for equal priority the oldest
+            if (a.priority != b.priority) {
+                return a.priority > b.priority;
+            }
+            return a.seq > b.seq;
+        }
+    };
+
+    std::priority_queue<Task, std::vector<Task>, TaskOrder> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condTask;
+    bool m_active{true};
+    uint64_t m_seq{};
+    uint32_t m_running{};
+    size_t m_maxQueued{};
+    uint64_t m_completed{};
+    std::chrono::steady_clock::duration m_sumLatency{};
+    std::chrono::steady_clock::duration m_maxLatency{};
+    std::vector<std::thread> m_threads;
+
+    static uint32_t m_configuredThreads;
+};
+
+// keeps track of the tasks submitted by a owner,
+//   so the owner may wait for them before it gets destroyed
+//   (declare it as last member, so it is destroyed first).
+class TaskGroup
+{
+public:
+    TaskGroup() = default;
+    explicit TaskGroup(const TaskGroup& orig) = delete;
+    virtual ~TaskGroup();
+
+    template <typename F>
+    auto submit(Priority priority, F&& fun) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            ++m_pending;
+        }
+        return Executor::get().submit(priority, [this, fun = std::forward<F>(fun)] () mutable {
+            Done done{this};    // also on exception
+            return fun();
+        });
+    }
+    // wait until all submitted tasks are finished
+    void wait();
+
+protected:
+    void finished();
+
+private:
+    struct Done
+    {
+        TaskGroup* group;
+        ~Done()
+        {
+            group->finished();
+        }
+    };
+    std::mutex m_mutex;
+    std::condition_variable m_condDone;
+    uint32_t m_pending{};
+};
+
+} // namespace psc::util
@@ -21,9 +21,12 @@
 
 #include <gtkmm.h>
 #include <future>
+#include <atomic>
+#include <mutex>
 
 #include "ApplicationSupport.hpp"
 #include "ImageList.hpp"
+#include "Executor.hpp"
 
 enum class ViewMode
 {
@@ -40,7 +43,7 @@ class ImageArea
 {
 public:
     ImageArea(BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>& builder, ApplicationSupport& appSupport, ImageViewIntf* imageView);
-    virtual ~ImageArea() = default;
+    virtual ~ImageArea();
     void setFile(const Glib::RefPtr<Gio::File> file);
     Glib::RefPtr<DisplayImage> getDisplayImage();
     ViewMode getViewMode();
@@ -52,7 +55,9 @@ public:
     void crop();
 protected:
     bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr) override;
-    Glib::RefPtr<Gdk::Pixbuf> readPicture();
+    Glib::RefPtr<Gdk::Pixbuf> readPicture(const Glib::RefPtr<Gio::File>& file, uint64_t generation);
+    // keeps the result for onNotifyLoad, then notifies
+    void loaded(const Glib::RefPtr<Gdk::Pixbuf>& pixbuf, uint64_t generation);
     void onNotifyLoad();
     void resetSelection();
     double getScale();
@@ -69,11 +74,15 @@ protected:
     Glib::RefPtr<DisplayImage> m_displayImage;
     Glib::RefPtr<Gdk::Pixbuf> m_scaledImage;
     Glib::Dispatcher m_drawDispatcher;
-    std::future<Glib::RefPtr<Gdk::Pixbuf> > m_pictureReader;
+    std::mutex m_loadedMutex;                   // guards the loaded values
+    Glib::RefPtr<Gdk::Pixbuf> m_loaded;
+    uint64_t m_loadedGeneration{0};             // of m_loaded, zero if taken
     ApplicationSupport& m_appSupport;
     ViewMode m_viewMode{ViewMode::FIT};
     ImageViewIntf* m_imageView{nullptr};
     double x0{0.0},y0{0.0},x1{0.0},y1{0.0}; // selection in picture coords
     bool x0Move{false},y0Move{false},x1Move{false},y1Move{false};   // selection value dragged by mouse
+    std::atomic<uint64_t> m_loadGeneration{0};  // allows skipping outdated loads
+    psc::util::TaskGroup m_loads;               // keep last, the loads use our members
 };
 
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <gtkmm.h>
+#include <functional>
 
 
 /*
@@ -42,15 +43,29 @@ class ImageList
 : public Gtk::TreeStore
 {
 public:
-    virtual ~ImageList() = default;
+    using SlotInfo = sigc::slot<void, const Glib::RefPtr<Gio::File>&, const Glib::RefPtr<Gio::FileInfo>&>;
+
+    virtual ~ImageList();
     static Glib::RefPtr<ImageList> create();
 
     void fillList(const Glib::RefPtr<Gio::File> file);
+    // use with the infos from queryAsync, the file infos are placed at front
+    void fillList(const Glib::RefPtr<Gio::File>& file, const Glib::RefPtr<Gio::FileInfo>& info);
+    // query the infos without blocking, the slot will be called from the main loop,
+    //   a pending query is cancelled (so only the latest will be delivered)
+    void queryAsync(const Glib::RefPtr<Gio::File>& file, const SlotInfo& slot);
+    void cancelQuery();
+    // detach the list from the view while filling, avoids notifying the view for each row
+    static void fillDetached(const Glib::RefPtr<Gtk::TreeView>& view
+                           , const Glib::RefPtr<ImageList>& list
+                           , const std::function<void()>& fill);
     static VariableColumns m_variableColumns;
     void fillList(Glib::RefPtr<DisplayImage>& pixbuf);
 
     Gtk::TreeIter appendList(const char *name, const Glib::ustring& value);
     Gtk::TreeIter appendList(Gtk::TreeIter& node, const char *name, const Glib::ustring& value);
+    Gtk::TreeIter prependList(const char *name, const Glib::ustring& value);
+    static constexpr auto FILE_ATTRIBUTES{"standard::*,time::*,owner::*,unix::*,metadata::*"};
 protected:
     void appendList(Gtk::TreeIter& node, const char *name, const Glib::DateTime& modified);
     static Glib::ustring formatScale(guint64 value);    // , const char *suffix, double scale = 1024.0
@@ -58,5 +73,7 @@ protected:
     std::map<Glib::ustring, Glib::ustring> getOptions(Glib::RefPtr<Gdk::Pixbuf>& pixbuf);
 private:
     ImageList();
+
+    Glib::RefPtr<Gio::Cancellable> m_cancellable;
 };
 
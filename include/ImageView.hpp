@@ -26,6 +26,7 @@
 #include "ApplicationSupport.hpp"
 #include "ImageList.hpp"
 #include "Mode.hpp"
+#include "PixbufFormats.hpp"
 
 class ImageFilter
 : public Gtk::FileFilter
@@ -65,7 +66,7 @@ public:
             , std::shared_ptr<Mode> mode
             , ApplicationSupport& appSupport
             , bool instantiateImageview = true);
-    virtual ~ImageView() = default;
+    virtual ~ImageView();
 
     virtual void on_hide() override;
     void showFront();
@@ -78,6 +79,8 @@ public:
     static bool is_mime_gdk_readable(const Glib::ustring& mime);
     std::shared_ptr<Mode> getMode();
     void refresh();
+    // how files are identified when browsing a directory
+    void setScanMode(ScanMode scanMode);
 protected:
     Glib::RefPtr<Gio::File> getDefaultDir();
     std::shared_ptr<Mode> createDirMode();
@@ -91,6 +94,9 @@ protected:
     void on_menu_n(gint n) override;
     void on_menu_view(ViewMode viewMode);
     void on_select();
+    void on_mode_changed();
+    void on_front_changed();
+    void updateList(const std::function<void()>& fill);
     virtual Gtk::Menu* build_popup(int x, int y);
 
     ImageArea* m_content{nullptr};
@@ -107,6 +113,7 @@ protected:
     Gtk::Button* m_prevBtn{nullptr};
     Gtk::Button* m_nextBtn{nullptr};
     bool m_select{false};
+    ScanMode m_scanMode{ScanMode::Fast};
     static constexpr auto CONF_GROUP{"view"};
     static constexpr auto CONF_PREFIX{"view"};
     static constexpr auto CONF_PATH{"path"};
@@ -21,11 +21,32 @@
 #include <functional>
 #include <source_location>
 #include <memory>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <string>
+#include <tuple>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+#include <concepts>
+#include <utility>
+#include <thread>
+#include <unordered_map>
+#include <optional>
 #include <glibmm.h>
 #include <giomm-2.4/giomm.h>
 
 #include "StringUtils.hpp"
+#include "ConcurrentCollections.hpp"
 #include "psc_format.hpp"
+#include "genericimg_config.h"
+
+#ifndef LOG_COMPILED_LEVEL
+#define LOG_COMPILED_LEVEL 7    // keep all
+#endif
 
 namespace psc {
 namespace log {
@@ -35,7 +56,8 @@ enum class Type {
     Default,
     File,
     Console,
-    None
+    None,
+    Binary      // see BinaryPlugin
 };
 
 enum class Level
@@ -51,6 +73,20 @@ enum class Level
     , Debug
 };
 
+// the minimum level that is compiled in, see meson option log_level
+constexpr Level compiled_Level{static_cast<Level>(LOG_COMPILED_LEVEL)};
+
+constexpr bool
+isCompiled(Level level)
+{
+    return level <= compiled_Level;
+}
+
+enum class WriteMode {
+    Sync,       // write on the calling thread
+    Async       // queue and write on a background thread
+};
+
 constexpr std::initializer_list<Level> all_Levels = {
       Level::Severe
     , Level::Alert
@@ -63,6 +99,272 @@ constexpr std::initializer_list<Level> all_Levels = {
 };
 
 
+// the format and a copy of the arguments, so the formatting may be done later.
+//   Strings given by pointer or view are copied as std::string
+//   other arguments are copied as they are (so do not pass pointers that may dangle).
+//   Small arguments are kept inline, so they do not require an allocation.
+class LogFormat
+{
+public:
+    LogFormat() = default;
+    template <typename... Args>
+    LogFormat(std::string_view format, Args&&... args)
+    : m_format{format}
+    {
+        using Tuple = std::tuple<Stored<Args>...>;
+        if constexpr (sizeof(Tuple) <= INLINE_SIZE
+                   && alignof(Tuple) <= alignof(std::max_align_t)) {
+            new (m_storage) Tuple(std::forward<Args>(args)...);
+            m_ops = &InlineOps<Tuple>::ops;
+        }
+        else {
+            *reinterpret_cast<Tuple**>(m_storage) = new Tuple(std::forward<Args>(args)...);
+            m_ops = &HeapOps<Tuple>::ops;
+        }
+    }
+    LogFormat(const LogFormat& other)
+    : m_format{other.m_format}
+    , m_ops{other.m_ops}
+    {
+        if (m_ops) {
+            m_ops->copy(m_storage, other.m_storage);
+        }
+    }
+    LogFormat(LogFormat&& other) noexcept
+    : m_format{other.m_format}
+    , m_ops{std::exchange(other.m_ops, nullptr)}
+    {
+        if (m_ops) {
+            m_ops->move(m_storage, other.m_storage);
+        }
+    }
+    LogFormat& operator=(const LogFormat& other)
+    {
+        if (this != &other) {
+            LogFormat copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+    LogFormat& operator=(LogFormat&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            m_format = other.m_format;
+            m_ops = std::exchange(other.m_ops, nullptr);
+            if (m_ops) {
+                m_ops->move(m_storage, other.m_storage);
+            }
+        }
+        return *this;
+    }
+    ~LogFormat()
+    {
+        reset();
+    }
+    explicit operator bool() const
+    {
+        return m_ops != nullptr;
+    }
+    std::string format() const
+    {
+        return m_ops ? m_ops->format(m_format, m_storage) : std::string();
+    }
+    void reset()
+    {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+    static constexpr size_t INLINE_SIZE{64u};
+
+private:
+    template <typename T>
+    using Stored = std::conditional_t<std::is_convertible_v<std::decay_t<T>, std::string_view>
+                                   && !std::is_same_v<std::decay_t<T>, Glib::ustring>
+                                    , std::string
+                                    , std::decay_t<T>>;
+    struct Ops
+    {
+        std::string (*format)(std::string_view format, const void* storage);
+        void (*copy)(void* dest, const void* src);
+        void (*move)(void* dest, void* src);        // leaves src destroyed
+        void (*destroy)(void* storage);
+    };
+    template <typename Tuple>
+    static std::string formatTuple(std::string_view format, const Tuple& tuple)
+    {
+        return std::apply([format] (const auto&... args) {
+            return psc::fmt::vformat(format, psc::fmt::make_format_args(args...));
+        }, tuple);
+    }
+    template <typename Tuple>
+    struct InlineOps
+    {
+        static constexpr Ops ops{
+              [] (std::string_view format, const void* storage) {
+                  return formatTuple(format, *static_cast<const Tuple*>(storage));
+              }
+            , [] (void* dest, const void* src) {
+                  new (dest) Tuple(*static_cast<const Tuple*>(src));
+              }
+            , [] (void* dest, void* src) {
+                  auto from = static_cast<Tuple*>(src);
+                  new (dest) Tuple(std::move(*from));
+                  from->~Tuple();
+              }
+            , [] (void* storage) {
+                  static_cast<Tuple*>(storage)->~Tuple();
+              }
+        };
+    };
+    template <typename Tuple>
+    struct HeapOps
+    {
+        static constexpr Ops ops{
+              [] (std::string_view format, const void* storage) {
+                  return formatTuple(format, **static_cast<Tuple* const*>(storage));
+              }
+            , [] (void* dest, const void* src) {
+                  *static_cast<Tuple**>(dest) = new Tuple(**static_cast<Tuple* const*>(src));
+              }
+            , [] (void* dest, void* src) {
+                  *static_cast<Tuple**>(dest) = *static_cast<Tuple**>(src);
+              }
+            , [] (void* storage) {
+                  delete *static_cast<Tuple**>(storage);
+              }
+        };
+    };
+
+    std::string_view m_format;      // a literal, as it was checked at compile time
+    const Ops* m_ops{nullptr};
+    alignas(std::max_align_t) std::byte m_storage[INLINE_SIZE];
+};
+
+// a log call, keeps the values so it may be written later
+struct LogRecord
+{
+    Level level{Level::Info};
+    Glib::ustring msg;
+    std::source_location location;
+    std::chrono::system_clock::time_point time;
+    uint32_t thread{};      // see Log::getThreadId
+    LogFormat format;       // if set, the msg is formatted by resolve
+
+    void resolve()
+    {
+        if (format) {
+            msg = format.format();
+            format.reset();
+        }
+    }
+};
+
+// a format string checked at compile time, with the location of the call
+//   (as the arguments come after it)
+template <typename... Args>
+struct LogFormatString
+{
+    template <typename T>
+        requires std::convertible_to<const T&, std::string_view>
+    consteval LogFormatString(const T& format
+                            , const std::source_location location = std::source_location::current())
+    : m_format{format}
+    , m_location{location}
+    {
+    }
+    psc::fmt::format_string<Args...> m_format;
+    std::source_location m_location;
+};
+
+// formats the timestamp as "%F %T.mmm" (local time),
+//   the date and time are kept for the current second (for each thread)
+//   so most calls only write the milliseconds.
+class TimestampFormat
+{
+public:
+    static constexpr size_t LENGTH{23u};
+    // the view is valid until the next call of the same thread
+    static std::string_view format(std::chrono::system_clock::time_point time);
+};
+
+// identifies a call site, the names are compared by address
+//   (source_location uses static strings)
+struct LogLocationKey
+{
+    LogLocationKey(const std::source_location& location)
+    : file{location.file_name()}
+    , line{location.line()}
+    , column{location.column()}
+    {
+    }
+    bool operator==(const LogLocationKey& other) const = default;
+    const char* file;
+    uint32_t line;
+    uint32_t column;
+};
+
+struct LogLocationHash
+{
+    size_t operator()(const LogLocationKey& key) const;
+};
+
+// limits the messages for each call site with a token bucket,
+//   the number of suppressed messages is reported with the next message
+//   that passes (so at most once for each token), periodically or on close.
+//   A known site takes no exclusive lock, only a new site is inserted with one.
+class LogRateLimit
+{
+public:
+    LogRateLimit();
+    explicit LogRateLimit(const LogRateLimit& orig) = delete;
+    ~LogRateLimit() = default;
+
+    // allow burst messages at once, refilled with perSecond, zero burst disables,
+    //   the pending counts are reported after reportInterval
+    void setLimit(uint32_t burst, double perSecond
+                , std::chrono::seconds reportInterval = REPORT_INTERVAL);
+    // false if the message shall be suppressed,
+    //   otherwise suppressed is set to the count to report before the message
+    bool acquire(Level level, const std::source_location& location, uint32_t& suppressed);
+    struct Suppressed
+    {
+        Level level;
+        std::source_location location;
+        uint32_t count;
+    };
+    // the sites with pending counts, these are reset
+    std::vector<Suppressed> takeSuppressed();
+    // as takeSuppressed if the report interval passed, otherwise empty
+    std::vector<Suppressed> takeSuppressedDue();
+    static constexpr uint32_t DEFAULT_BURST{20u};
+    static constexpr double DEFAULT_RATE{2.0};
+    static constexpr std::chrono::seconds REPORT_INTERVAL{10};
+private:
+    static int64_t now();
+    // the bucket is kept as the time it will be full again (as with GCRA),
+    //   so taking a token is a single compare exchange
+    struct Bucket
+    {
+        Bucket(Level level, const std::source_location& location)
+        : level{level}
+        , location{location}
+        {
+        }
+        std::atomic<int64_t> full{0};   // steady clock ns
+        std::atomic<uint32_t> suppressed{0u};
+        std::atomic<Level> level;       // of the last suppressed
+        const std::source_location location;
+    };
+    std::atomic<uint32_t> m_burst;
+    std::atomic<int64_t> m_interval;        // ns to refill one token
+    std::atomic<int64_t> m_reportInterval;  // ns
+    std::atomic<int64_t> m_nextReport;
+    TShardedMapConcurrent<LogLocationKey, std::shared_ptr<Bucket>, LogLocationHash> m_buckets;
+};
+
 class LogPlugin
 {
 public:
@@ -72,9 +374,37 @@ public:
     virtual void log(Level level
             , const Glib::ustring& msg
             , const std::source_location location) = 0;
+    // write a record that was created before,
+    //   the default is for plugins that use the current time anyway
+    virtual void write(const LogRecord& record);
+    // write some records (e.g. with one output call)
+    virtual void writeBatch(const std::vector<LogRecord>& records);
+    // write a record that may need formatting,
+    //   the default formats on the calling thread
+    virtual void writeDeferred(LogRecord&& record);
+    // make the written records persistent
+    virtual void flush()
+    {
+    }
     virtual void close()
     {
     }
+    // true if the plugin writes the lines as formatted by FilePlugin::format,
+    //   these are shared between the sinks of FanoutPlugin
+    virtual bool isText()
+    {
+        return false;
+    }
+    // one or more lines (only used if isText)
+    virtual void writeText(std::string_view text)
+    {
+    }
+    // the most detailed level the plugin writes (e.g. as decided by its sinks),
+    //   if given Log checks this in addition to its own level
+    virtual std::optional<Level> getLevel()
+    {
+        return std::nullopt;
+    }
 protected:
     Glib::ustring m_prefix;
 };
@@ -90,17 +420,66 @@ public:
     void log(Level level
             , const Glib::ustring& msg
             , const std::source_location location) override;
+    void write(const LogRecord& record) override;
+    void writeBatch(const std::vector<LogRecord>& records) override;
+    bool isText() override;
+    void writeText(std::string_view text) override;
+    // appends the line(s) for the record
+    static void format(const LogRecord& record, std::string& out);
+    // the file is rotated if it grows beyond the limit
     void setSizeLimit(goffset sizeLimit);
     goffset getSizeLimit();
+    // rotate also if the file was created longer ago than this, zero disables
+    void setMaxAge(std::chrono::seconds maxAge);
+    std::chrono::seconds getMaxAge();
+    // the rotated files to keep, name.log.1 stays plain the older ones are compressed,
+    //   zero discards the content on rotation
+    void setGenerations(uint32_t generations);
+    uint32_t getGenerations();
 
     void close() override;
     void create();
     static constexpr auto DEFAULT_SIZELIMITI{102400ul};
+    static constexpr auto DEFAULT_GENERATIONS{4u};
+    static constexpr auto COMPRESSED_EXTENSION = ".gz";
     void createLogFile(const Glib::RefPtr<Gio::File>& file);
+    // e.g. name.log.1 or name.log.2.gz
+    static std::string getGenerationPath(const std::string& path, uint32_t generation, bool compressed);
+    static constexpr auto LOG_EXTENSION = ".log";
 
+protected:
+    FilePlugin(const char* prefix, const char* extension);
+    void output(std::string_view out);
+    // these require m_mutex
+    void open();
+    void openFile(const Glib::RefPtr<Gio::File>& file);
+    // rotate or open if required, before using append
+    void prepare();
+    void append(std::string_view out);
+    // called on each open, created is true for a new (empty) file
+    virtual void opened(bool created);
+    bool isRotationDue();
+    void rotate();
+    // rotates, on failure rotation is disabled and the file kept
+    void rotateOrKeep();
+    // reports the first of consecutive failures, the next output retries
+    void failed(const Glib::Error& ex);
+    void waitCompress();
+    // runs on m_compressor
+    static void compress(const std::string& path, const std::string& compressedPath);
+    std::mutex m_mutex;         // only held for the output
 private:
+    std::string m_extension;
     Glib::RefPtr<Gio::FileOutputStream> m_outstream;
+    Glib::RefPtr<Gio::File> m_file;
     goffset m_sizeLimit;
+    goffset m_size{0};          // written to m_file
+    std::chrono::seconds m_maxAge{0};
+    std::chrono::system_clock::time_point m_created;    // of m_file
+    bool m_rotate{true};        // false after a rotation failed
+    bool m_failed{false};       // the failure was reported
+    uint32_t m_generations;
+    std::thread m_compressor;
 };
 
 
@@ -125,10 +504,48 @@ public:
     void log(Level level
             , std::function< Glib::ustring(void) >&& lambda
             , const std::source_location location = std::source_location::current());
+    // the format is checked at compile time, the arguments are copied
+    //   and the message is formatted by the plugin (with Async in the background)
+    template <typename... Args>
+    void log(Level level
+            , LogFormatString<std::type_identity_t<Args>...> format
+            , Args&&... args)
+    {
+        if (m_plugin && isPassing(level, format.m_location)) {
+            m_plugin->writeDeferred(LogRecord{level, Glib::ustring(), format.m_location
+                                            , std::chrono::system_clock::now(), getThreadId()
+                                            , LogFormat(format.m_format.get(), std::forward<Args>(args)...)});
+        }
+    }
+    // the level is given at compile time, so the call
+    //   is removed if it is below the compiled level
+    template <Level level, typename... Args>
+    void log(LogFormatString<std::type_identity_t<Args>...> format
+            , Args&&... args)
+    {
+        if constexpr (isCompiled(level)) {
+            log(level, format, std::forward<Args>(args)...);
+        }
+    }
+    template <typename... Args>
+    void debug(LogFormatString<std::type_identity_t<Args>...> format
+            , Args&&... args)
+    {
+        log<Level::Debug>(format, std::forward<Args>(args)...);
+    }
     inline bool isLoggable(Level level)
     {
-        return level <= m_level;
+        return isCompiled(level)
+            && level <= m_level.load(std::memory_order_relaxed)
+            && (!m_pluginLevel
+             || level <= m_plugin->getLevel().value_or(Level::Debug));
     }
+    // the messages of each call site are limited to a burst of messages and a rate,
+    //   the levels Crit and above are always logged, zero burst disables
+    //   the suppressed are reported after reportInterval with a passing message or on close
+    void setRateLimit(uint32_t burst = LogRateLimit::DEFAULT_BURST
+                    , double perSecond = LogRateLimit::DEFAULT_RATE
+                    , std::chrono::seconds reportInterval = LogRateLimit::REPORT_INTERVAL);
     [[deprecated("see logAdd")]]
     static void logNow(Level level
             , const Glib::ustring& msg
@@ -145,24 +562,82 @@ public:
     static void logAdd(Level level
             , std::function< Glib::ustring(void) >&& lambda
 	    , const std::source_location location = std::source_location::current());
+    // with the level at compile time see log
+    template <Level level, typename... Args>
+    static void logAdd(LogFormatString<std::type_identity_t<Args>...> format
+            , Args&&... args)
+    {
+        if constexpr (isCompiled(level)) {
+            logAdd(level, format, std::forward<Args>(args)...);
+        }
+    }
+    template <Level level, typename F>
+        requires std::invocable<F>
+    static void logAdd(F&& lambda
+	    , const std::source_location location = std::source_location::current())
+    {
+        if constexpr (isCompiled(level)) {
+            auto log = m_instance.load(std::memory_order_acquire);
+            if (log == nullptr
+             || log->isLoggable(level)) {   // avoid the std::function if not logged
+                logAdd(level, std::function< Glib::ustring(void) >(std::forward<F>(lambda)), location);
+            }
+        }
+    }
+    // deferred formatting see log
+    template <typename... Args>
+    static void logAdd(Level level
+            , LogFormatString<std::type_identity_t<Args>...> format
+            , Args&&... args)
+    {
+        auto log = m_instance.load(std::memory_order_acquire);
+        if (log) {
+            log->log(level, format, std::forward<Args>(args)...);
+        }
+        else {
+            std::cout << getTimestamp()
+                      << " " << getLevel(level)
+                      << " " << psc::fmt::format(format.m_format, std::forward<Args>(args)...) << std::endl;
+        }
+    }
     Level getLevel();
     void setLevel(Level level);
     std::shared_ptr<LogPlugin> getPlugin();
     static Glib::ustring getTimestamp();
+    static Glib::ustring getTimestamp(std::chrono::system_clock::time_point time);
     static Level getLevel(const Glib::ustring& level);
     // this is a convenience method to use a unified log
     //   for different parts of a application.
-    // The parameters are only honored on first invocation
-    static std::shared_ptr<Log> create(const char* prefix, Type type = Type::Default);
+    // The parameters are only honored on first invocation (also if called concurrently),
+    //   with Async the plugin is written by a background thread.
+    static std::shared_ptr<Log> create(const char* prefix, Type type = Type::Default
+                                     , WriteMode writeMode = WriteMode::Sync);
+    // the same with a plugin created before e.g. a FanoutPlugin
+    static std::shared_ptr<Log> create(const std::shared_ptr<LogPlugin>& plugin
+                                     , WriteMode writeMode = WriteMode::Sync);
+    // the plugin as used by create (empty for None)
+    static std::shared_ptr<LogPlugin> createPlugin(const char* prefix, Type type);
     // get a global log if it exists
     static std::shared_ptr<Log> getGlobalLog();
     static const char* getLevel(Level level);   // these sames are shortened to 3
     static const char* getLevelFull(Level level);
+    // a small number for the calling thread (in order of the first use)
+    static uint32_t getThreadId();
     void close();
 private:
-    Level m_level;
+    // loggable and not rate limited, reports the suppressed messages
+    bool isPassing(Level level, const std::source_location& location);
+    void reportSuppressed(Level level, uint32_t count, const std::source_location& location);
+    // requires m_createOnce
+    static void install(std::shared_ptr<LogPlugin> plugin, WriteMode writeMode);
+
+    std::atomic<Level> m_level;
     std::shared_ptr<LogPlugin> m_plugin;
-    static std::shared_ptr<Log> m_log;
+    const bool m_pluginLevel;       // the plugin has a level
+    LogRateLimit m_rateLimit;
+    static std::shared_ptr<Log> m_log;          // only set once, the log is never destroyed
+    static std::atomic<Log*> m_instance;        // for logAdd, set after m_log
+    static std::once_flag m_createOnce;
 };
 
 
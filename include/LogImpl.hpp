@@ -19,8 +19,20 @@
 #pragma once
 
 #include <source_location>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <array>
+#include <unordered_map>
+#include <cstdint>
+#include <string_view>
+#include <string>
+#include <functional>
+#include <memory>
 
 #include "Log.hpp"
+#include "ThreadWorker.hpp"
 #include "genericimg_config.h"
 
 
@@ -38,6 +50,11 @@ public:
     void log(Level level
             , const Glib::ustring& msg
             , const std::source_location location) override;
+    void write(const LogRecord& record) override;
+    static constexpr size_t FIELDS{6u};
+protected:
+    // builds the fields without allocation (for each message)
+    void send(Level level, std::string_view msg, const std::source_location& location);
 };
 #endif
 
@@ -68,8 +85,197 @@ public:
     void log(Level level
             , const Glib::ustring& msg
             , const std::source_location location) override;
+    void write(const LogRecord& record) override;
+private:
+    std::mutex m_mutex;     // keep the lines together
 };
 
+enum class BinaryRecordType : uint8_t
+{
+      Entry = 0
+    , Location = 1    // describes a location id, followed by the line (uint32_t), file '\0' function
+};
+
+// precedes each record of a binary log (in native byte order)
+struct BinaryRecordHeader
+{
+    int64_t time;           // µs since epoch
+    uint32_t location;      // interned id
+    uint32_t thread;
+    uint32_t length;        // of the following bytes
+    BinaryRecordType type;
+    uint8_t level;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(BinaryRecordHeader) == 24u, "keep the header without padding");
+
+// writes the records in binary form, this saves the formatting
+//   and allows reading them without parsing (see LogViewBinary).
+//   The locations are interned, each id is described by a Location record
+//   before its first use in a file.
+class BinaryPlugin
+: public FilePlugin
+{
+public:
+    BinaryPlugin(const char* prefix);
+    explicit BinaryPlugin(const BinaryPlugin& orig) = delete;
+    ~BinaryPlugin() = default;
+
+    void write(const LogRecord& record) override;
+    void writeBatch(const std::vector<LogRecord>& records) override;
+    bool isText() override;
+
+    static constexpr auto EXTENSION = ".blog";
+    // starts each file
+    static constexpr std::array<char, 8> MAGIC{'P', 'S', 'C', 'B', 'L', 'O', 'G', '1'};
+    // of a record, longer messages are truncated (a reader rejects more)
+    static constexpr uint32_t MAX_LENGTH{1u << 20u};
+protected:
+    void opened(bool created) override;
+    // these require m_mutex, as the location descriptions depend on the file
+    void encode(const LogRecord& record, std::string& out);
+    uint32_t intern(const std::source_location& location, std::string& out);
+private:
+    std::unordered_map<LogLocationKey, uint32_t, LogLocationHash> m_locations;
+    std::vector<bool> m_described;      // by id for the current file
+};
+
+// keeps the last lines in memory e.g. to show the details before an error
+class RingPlugin
+: public LogPlugin
+{
+public:
+    RingPlugin(size_t capacity = DEFAULT_CAPACITY);
+    explicit RingPlugin(const RingPlugin& orig) = delete;
+    ~RingPlugin() = default;
+
+    void log(Level level
+            , const Glib::ustring& msg
+            , const std::source_location location) override;
+    void write(const LogRecord& record) override;
+    bool isText() override;
+    void writeText(std::string_view text) override;
+    // the oldest first
+    std::vector<std::string> getLines();
+    void clear();
+    static constexpr size_t DEFAULT_CAPACITY{1024u};
+private:
+    std::mutex m_mutex;
+    std::vector<std::string> m_lines;   // the strings are reused
+    size_t m_next{0u};
+    size_t m_count{0u};
+};
+
+// a plugin used by FanoutPlugin, with its own level and filter
+class LogSink
+{
+public:
+    // return false to skip the record
+    using Filter = std::function<bool(const LogRecord& record)>;
+    LogSink(const std::shared_ptr<LogPlugin>& plugin, Level level, const Filter& filter);
+    explicit LogSink(const LogSink& orig) = delete;
+    ~LogSink() = default;
+
+    bool accepts(const LogRecord& record);
+    Level getLevel();
+    const std::shared_ptr<LogPlugin>& getPlugin();
+protected:
+    friend class FanoutPlugin;
+    // use FanoutPlugin::setSinkLevel, so the fan-out level follows
+    void setLevel(Level level);
+private:
+    std::shared_ptr<LogPlugin> m_plugin;
+    std::atomic<Level> m_level;
+    Filter m_filter;
+};
+
+typedef std::shared_ptr<LogSink> pLogSink;
+
+// writes each record to all sinks that accept it,
+//   a deferred message is formatted once, and the lines are formatted once
+//   for all text sinks (see LogPlugin::isText).
+//   Log checks the level of the plugin, so it passes what at least one sink accepts.
+class FanoutPlugin
+: public LogPlugin
+{
+public:
+    FanoutPlugin();
+    explicit FanoutPlugin(const FanoutPlugin& orig) = delete;
+    ~FanoutPlugin() = default;
+
+    pLogSink addSink(const std::shared_ptr<LogPlugin>& plugin
+                   , Level level = Level::Debug
+                   , const LogSink::Filter& filter = LogSink::Filter());
+    void removeSink(const pLogSink& sink);
+    void setSinkLevel(const pLogSink& sink, Level level);
+    // the most detailed level of the sinks
+    std::optional<Level> getLevel() override;
+
+    void log(Level level
+            , const Glib::ustring& msg
+            , const std::source_location location) override;
+    void write(const LogRecord& record) override;
+    void writeBatch(const std::vector<LogRecord>& records) override;
+    void writeDeferred(LogRecord&& record) override;
+    void flush() override;
+    void close() override;
+private:
+    using Sinks = std::vector<pLogSink>;
+    // requires m_mutex
+    void updateLevel(const Sinks& sinks);
+    std::mutex m_mutex;     // for changing the sinks
+    // replaced on change, so writing does not wait for m_mutex
+    //   (but with libstdc++ each load takes a short internal lock, as atomic<shared_ptr> is not lock-free)
+    std::atomic<std::shared_ptr<const Sinks>> m_sinks;
+    std::atomic<Level> m_level{Level::Severe};  // of the sinks, checked for each message so kept apart
+};
+
+// queues the records and writes them with a background thread,
+//   so the callers are not delayed by the output.
+//   Records with level Crit or above are written before log returns,
+//   on close (or destruction) all queued records are written,
+//   records logged after close are written directly to the target.
+class AsyncPlugin
+: public LogPlugin
+{
+public:
+    AsyncPlugin(const std::shared_ptr<LogPlugin>& target);
+    explicit AsyncPlugin(const AsyncPlugin& orig) = delete;
+    ~AsyncPlugin();
+
+    void log(Level level
+            , const Glib::ustring& msg
+            , const std::source_location location) override;
+    void write(const LogRecord& record) override;
+    // the formatting is done by the writer
+    void writeDeferred(LogRecord&& record) override;
+    // wait until the records queued before are written
+    void flush() override;
+    void close() override;
+    // of the target
+    std::optional<Level> getLevel() override;
+    std::shared_ptr<LogPlugin> getTarget();
+    static constexpr size_t QUEUE_SIZE{4096u};
+private:
+    void run();
+    // wait until the records up to the ticket (the queue sequence number + 1) are written
+    void waitWritten(uint64_t ticket);
+
+    static constexpr uint64_t CLOSED{static_cast<uint64_t>(1u) << 63u};
+
+    std::shared_ptr<LogPlugin> m_target;
+    RingQueue<LogRecord, QUEUE_SIZE> m_queue;
+    std::atomic<uint32_t> m_producers{0u};  // inside writeDeferred, close waits for them
+    std::atomic<bool> m_closing{false};
+    // counts the pushes (to wake the writer) and includes the CLOSED bit
+    std::atomic<uint64_t> m_state{0u};
+    // the records written, as they are written in queue order
+    //   all records with a sequence number below are done (wakes flush)
+    std::atomic<uint64_t> m_written{0u};
+    std::mutex m_closeMutex;                // serializes close
+    std::thread m_writer;
+};
 
 } /* namespace psc::log */
 
@@ -0,0 +1,79 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "LogViewFile.hpp"
+#include "LogImpl.hpp"
+
+
+namespace psc::log {
+
+class LogViewBinary;
+
+typedef std::shared_ptr<LogViewBinary> pLogViewBinary;
+
+// reads the files written by BinaryPlugin,
+//   the records are used as stored, no text parsing is required.
+class LogViewBinary
+: public LogViewFile
+{
+public:
+    LogViewBinary();
+    explicit LogViewBinary(const LogViewBinary& orig) = delete;
+    virtual LogViewIterator begin() override;
+    virtual LogViewIterator end() override;
+    // prefer this creation method
+    static pLogViewBinary create();
+
+    static bool readMagic(std::istream& stream);
+    // throws std::ios_base::failure for an implausible length
+    static void readHeader(std::istream& stream, BinaryRecordHeader& header);
+    // as "file:line function" by id
+    static void readLocation(std::istream& stream, const BinaryRecordHeader& header, std::vector<std::string>& locations);
+    static constexpr auto DAY_USEC{LogDays::SECONDS_PER_DAY * LogTime::USEC};
+    static constexpr auto HOUR_USEC{60l * 60l * LogTime::USEC};
+protected:
+    bool isListed(const std::filesystem::path& path) override;
+    // only the headers are read
+    std::map<LogDays, uint64_t> groupDays(const std::filesystem::path& path) override;
+private:
+};
+
+
+struct LogViewBinaryIterator
+: public LogViewFileIterator
+{
+    // constructor
+    LogViewBinaryIterator()
+    : LogViewFileIterator::LogViewFileIterator()
+    {
+    }
+    LogViewBinaryIterator(const std::list<pLogViewIdentifier>& query, const pLogViewFile& logViewFile);
+
+    LogViewEntry parse() override;
+protected:
+    std::vector<std::string> m_locations;
+};
+
+
+} /* namespace psc::log */
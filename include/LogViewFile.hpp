@@ -20,6 +20,8 @@
 
 #include <chrono>
 #include <fstream>
+#include <istream>
+#include <memory>
 #include <filesystem>
 
 #include "Log.hpp"
@@ -62,8 +64,17 @@ public:
 
     //static constexpr auto FULL_SCAN_LIMIT = 1024l*1024l;
     static constexpr auto LOG_EXTENSTION = ".log";
+    static constexpr size_t PARALLEL_BYTES{4u*1024u*1024u};
+    // includes the generations rotated by FilePlugin
+    static bool isLogFile(const std::filesystem::path& path, const char* extension = LOG_EXTENSTION);
+    static bool isCompressed(const std::filesystem::path& path);
+    // opened in text-mode (compressed files are expanded)
+    static std::unique_ptr<std::istream> openStream(const std::filesystem::path& path);
 protected:
-    std::map<LogDays, uint64_t> groupDays(const std::filesystem::path& entry);
+    // the files that are shown by getIdentifiers
+    virtual bool isListed(const std::filesystem::path& path);
+    virtual std::map<LogDays, uint64_t> groupDays(const std::filesystem::path& entry);
+    void groupDays(const std::filesystem::path& entry, uint64_t lo, uint64_t hi, std::map<LogDays, uint64_t>& map);
     std::list<pLogViewIdentifier> m_query;
 private:
 };
@@ -106,7 +117,7 @@ struct LogViewFileIterator
     {
     }
     LogViewFileIterator(const std::list<pLogViewIdentifier>& query, const pLogViewFile& logViewFile);
-    virtual ~LogViewFileIterator();
+    virtual ~LogViewFileIterator() = default;
     // member functions
     value_type get() const override;
 
@@ -116,7 +127,7 @@ struct LogViewFileIterator
     static constexpr auto SIZE_LIMIT = 32l*1024l;
 protected:
     uint64_t m_pos;
-    std::ifstream m_stat;
+    std::unique_ptr<std::istream> m_stat;
     LogViewEntry m_logViewEntry;
     pLogViewFile m_logViewFile;
     LogDays m_viewDay;
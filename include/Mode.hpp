@@ -20,6 +20,7 @@
 
 #include <vector>
 #include <memory>
+#include <functional>
 #include <gtkmm.h>
 
 class DisplayImage;
@@ -41,7 +42,8 @@ public:
     virtual ~Mode() = default;
 
     virtual void show(ViewIntf* viewIntf) = 0;
-    virtual void buildMenu(Gtk::Menu* subMenu, ViewIntf* imageView, function_ptr fun) = 0;
+    // adds the navigation items to the popup menu (no longer a submenu created by the caller)
+    virtual void buildMenu(Gtk::Menu* popupMenu, ViewIntf* imageView, function_ptr fun) = 0;
     virtual bool isComplete() = 0;
     virtual void prev() = 0;
     virtual void next() = 0;
@@ -60,7 +62,7 @@ public:
 
     bool isComplete() override;
     void show(ViewIntf* viewIntf) override;
-    void buildMenu(Gtk::Menu* subMenu, ViewIntf* imageView, function_ptr fun) override;
+    void buildMenu(Gtk::Menu* popupMenu, ViewIntf* imageView, function_ptr fun) override;
     void prev() override;
     void next() override;
     void set(int32_t n) override;
@@ -69,12 +71,59 @@ public:
 
     int32_t get();
     std::vector<Glib::RefPtr<Gio::File>> getPicts();
+    size_t size();
+    Glib::RefPtr<Gio::File> getFile(size_t idx);
+    // incremental updates, these expect the picts sorted by display name
+    //   and keep the front at the same file (if it is not the one removed)
+    bool add(const Glib::RefPtr<Gio::File>& file);
+    bool remove(const Glib::RefPtr<Gio::File>& file);
+    bool rename(const Glib::RefPtr<Gio::File>& file, const Glib::RefPtr<Gio::File>& renamed);
+    bool contains(const Glib::RefPtr<Gio::File>& file);
+    static Glib::ustring getSortName(const Glib::RefPtr<Gio::File>& file);
 protected:
     Glib::RefPtr<Gio::File> getFrontFile();
+    std::vector<Glib::RefPtr<Gio::File>>::iterator lowerBound(const std::string& sortKey);
+    static std::string getSortKey(const Glib::RefPtr<Gio::File>& file);
 
 private:
     int32_t m_front;
     std::vector<Glib::RefPtr<Gio::File>> m_picts;
+    // collated sort name for each of m_picts (same index),
+    //   keeps the comparisons cheap for the incremental updates
+    std::vector<std::string> m_sortKeys;
+};
+
+// paging for a directory, that follows the changes to the directory
+class DirMode
+: public PagingMode
+{
+public:
+    // the accept function decides which of the added files will be shown
+    DirMode(const Glib::RefPtr<Gio::File>& dir
+            , std::vector<Glib::RefPtr<Gio::File>>& picts
+            , const std::function<bool(const Glib::RefPtr<Gio::File>&)>& accept);
+    explicit DirMode(const DirMode& other) = delete;
+    virtual ~DirMode();
+
+    bool join(std::shared_ptr<Mode> other) override;
+    Glib::RefPtr<Gio::File> getDir();
+    // emitted after the list of files changed
+    sigc::signal<void> signal_changed();
+    // emitted after the shown file was removed, the front is the neighbour now
+    sigc::signal<void> signal_front_changed();
+protected:
+    void on_dir_changed(const Glib::RefPtr<Gio::File>& file
+                      , const Glib::RefPtr<Gio::File>& otherFile
+                      , Gio::FileMonitorEvent event);
+    void unwatch();
+
+private:
+    Glib::RefPtr<Gio::File> m_dir;
+    std::function<bool(const Glib::RefPtr<Gio::File>&)> m_accept;
+    Glib::RefPtr<Gio::FileMonitor> m_monitor;
+    sigc::connection m_monitorConn;
+    sigc::signal<void> m_signal_changed;
+    sigc::signal<void> m_signal_front_changed;
 };
 
 
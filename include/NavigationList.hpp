@@ -0,0 +1,121 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gtkmm.h>
+#include <vector>
+
+#include "Mode.hpp"
+
+class PagingColumns
+: public Gtk::TreeModel::ColumnRecord
+{
+public:
+    Gtk::TreeModelColumn<Glib::ustring> m_name;
+    Gtk::TreeModelColumn<int> m_index;
+    PagingColumns()
+    {
+        add(m_name);
+        add(m_index);
+    }
+};
+
+// a flat list over the files of a PagingMode,
+//   the rows are resolved when requested so the creation
+//   does not depend on the number of files (unless a filter is used).
+class PagingListModel
+: public Gtk::TreeModel
+, public Glib::Object
+{
+public:
+    virtual ~PagingListModel() = default;
+
+    // filter is matched case insensitive on any part of the name,
+    //   if the filter extends the one of previous (same mode unchanged)
+    //   only the rows of previous are checked, so typing narrows without a full scan
+    static Glib::RefPtr<PagingListModel> create(PagingMode* mode, const Glib::ustring& filter = ""
+                                              , const Glib::RefPtr<PagingListModel>& previous = Glib::RefPtr<PagingListModel>());
+    static PagingColumns m_columns;
+    // index into the paging mode (or -1 if out of range)
+    int32_t getIndex(const Gtk::TreeModel::Path& path) const;
+    // the row that shows the paging index (or -1 if filtered)
+    int32_t getRow(int32_t index) const;
+    int32_t getRowCount() const;
+
+protected:
+    PagingListModel(PagingMode* mode, const Glib::ustring& filter, const PagingListModel* previous);
+    Gtk::TreeModelFlags get_flags_vfunc() const override;
+    int get_n_columns_vfunc() const override;
+    GType get_column_type_vfunc(int index) const override;
+    void get_value_vfunc(const const_iterator& iter, int column, Glib::ValueBase& value) const override;
+    bool iter_next_vfunc(const iterator& iter, iterator& iter_next) const override;
+    bool iter_children_vfunc(const iterator& parent, iterator& iter) const override;
+    bool iter_has_child_vfunc(const const_iterator& iter) const override;
+    int iter_n_children_vfunc(const const_iterator& iter) const override;
+    int iter_n_root_children_vfunc() const override;
+    bool iter_nth_child_vfunc(const iterator& parent, int n, iterator& iter) const override;
+    bool iter_nth_root_child_vfunc(int n, iterator& iter) const override;
+    bool iter_parent_vfunc(const iterator& child, iterator& iter) const override;
+    Path get_path_vfunc(const const_iterator& iter) const override;
+    bool get_iter_vfunc(const Path& path, iterator& iter) const override;
+
+    int32_t toIndex(int32_t row) const;
+    bool is_valid(const const_iterator& iter) const;
+
+private:
+    PagingMode* m_mode;
+    Glib::ustring m_filter;     // casefolded
+    bool m_filtered{false};
+    std::vector<int32_t> m_rows;      // only used if filtered
+    int32_t m_count{0};
+    int m_stamp{1};
+};
+
+// type-ahead list to choose a file from a PagingMode
+class NavigationDialog
+: public Gtk::Dialog
+{
+public:
+    NavigationDialog(Gtk::Window* parent, PagingMode* mode);
+    explicit NavigationDialog(const NavigationDialog& orig) = delete;
+    virtual ~NavigationDialog();
+
+    // the chosen index or -1
+    int32_t getSelected();
+    // show modal, and call the function for a chosen file
+    static void choose(PagingMode* mode, ViewIntf* imageView, function_ptr fun);
+    // wait for a pause in typing before filtering
+    static constexpr unsigned int FILTER_DELAY_MS{200u};
+protected:
+    void on_search_changed();
+    void applyFilter(bool narrow);
+    void on_search_activate();
+    void on_row_activated(const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* column);
+    void on_mode_changed();
+    void select(int32_t index);
+
+private:
+    PagingMode* m_mode;
+    Gtk::SearchEntry m_search;
+    Gtk::ScrolledWindow m_scroll;
+    Gtk::TreeView m_view;
+    Glib::RefPtr<PagingListModel> m_model;
+    sigc::connection m_filterTimer;
+    int32_t m_selected{-1};
+};
@@ -0,0 +1,117 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "Executor.hpp"
+
+namespace psc::util {
+
+// Split index ranges over the executor threads, the calling thread takes part.
+//   Each participant works off its part in chunks of grain and when done
+//   steals half of what is left from others, so uneven chunks balance out.
+//   Helpers that do not get a thread (e.g. the executor is busy) are not
+//   waited for, so it is save to use this from an executor task
+//   and several users will share the threads instead of oversubscribing.
+
+// number of participants that will be used for the range
+uint32_t parallel_slots(size_t begin, size_t end, size_t grain
+                      , Executor& executor = Executor::get());
+// run fun(slot, lo, hi) for each chunk, slot identifies the participant
+//   (< slots, each is only used by one thread at a time).
+//   The first exception stops the distribution and is rethrown.
+void parallel_run(size_t begin, size_t end, size_t grain, uint32_t slots
+                , const std::function<void(uint32_t slot, size_t lo, size_t hi)>& fun
+                , Priority priority = Priority::Background
+                , Executor& executor = Executor::get());
+
+// run fun(lo, hi) for the chunks of [begin, end)
+inline void
+parallel_for(size_t begin, size_t end, size_t grain
+           , const std::function<void(size_t lo, size_t hi)>& fun
+           , Priority priority = Priority::Background)
+{
+    auto slots = parallel_slots(begin, end, grain);
+    parallel_run(begin, end, grain, slots, [&fun] (uint32_t, size_t lo, size_t hi) {
+        fun(lo, hi);
+    }, priority);
+}
+
+// accumulate(lo, hi, T& partial) for the chunks of [begin, end),
+//   the partial results are combined with combine(T& result, const T& partial),
+//   the order of chunks is not defined, so combine has to be commutative.
+template <typename T, typename Accumulate, typename Combine>
+T
+parallel_reduce(size_t begin, size_t end, size_t grain, const T& identity
+              , Accumulate accumulate, Combine combine
+              , Priority priority = Priority::Background)
+{
+    auto slots = parallel_slots(begin, end, grain);
+    std::vector<T> partials(slots, identity);
+    parallel_run(begin, end, grain, slots, [&] (uint32_t slot, size_t lo, size_t hi) {
+        accumulate(lo, hi, partials[slot]);
+    }, priority);
+    T result{identity};
+    for (auto& partial : partials) {
+        combine(result, partial);
+    }
+    return result;
+}
+
+// sort the chunks in parallel, and merge them pairwise (each round in parallel)
+template <typename RandomIt, typename Compare>
+void
+parallel_sort(RandomIt first, RandomIt last, Compare comp
+            , size_t grain = 4096u
+            , Priority priority = Priority::Background)
+{
+    const size_t size = static_cast<size_t>(std::distance(first, last));
+    const size_t chunks = parallel_slots(0u, size, grain);
+    if (chunks <= 1u) {
+        std::sort(first, last, comp);
+        return;
+    }
+    const size_t chunkSize = (size + chunks - 1u) / chunks;
+    parallel_for(0u, chunks, 1u, [&] (size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; ++c) {
+            auto begin = first + std::min(size, c * chunkSize);
+            auto end = first + std::min(size, (c + 1u) * chunkSize);
+            std::sort(begin, end, comp);
+        }
+    }, priority);
+    for (size_t width = chunkSize; width < size; width *= 2u) {
+        const size_t pairs = (size + 2u * width - 1u) / (2u * width);
+        parallel_for(0u, pairs, 1u, [&] (size_t lo, size_t hi) {
+            for (size_t p = lo; p < hi; ++p) {
+                auto begin = p * 2u * width;
+                auto middle = std::min(size, begin + width);
+                auto end = std::min(size, begin + 2u * width);
+                std::inplace_merge(first + begin, first + middle, first + end, comp);
+            }
+        }, priority);
+    }
+}
+
+} // namespace psc::util
@@ -38,6 +38,7 @@ public:
     HPDF_Image getPdfImage();
     void loadPng(const std::string& filename);
     void load(const Cairo::RefPtr<Cairo::ImageSurface>& cimage);
+    static constexpr size_t PARALLEL_ROWS{64u};
 
 private:
     HPDF_Image m_image{nullptr};
@@ -0,0 +1,314 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "ConcurrentCollections.hpp"
+#include "Executor.hpp"
+
+namespace psc::util {
+
+// Chains stages that run on their own threads, connected by bounded queues
+//   e.g. enumerate -> read -> decode -> analyse -> sink.
+//   A full queue blocks the producing stage (backpressure),
+//   so i/o and compute overlap without buffering everything.
+//   As stages wait on the queues they do not use the executor.
+//   To show results use a ThreadWorker that waits for the pipeline
+//   in doInBackground, notifies from the sink and passes its token.
+
+struct StageMetrics
+{
+    std::string name;
+    uint32_t threads{};
+    uint64_t processed{};   // values taken (for the source produced)
+    uint64_t emitted{};     // values passed on
+    size_t queued{};        // waiting for the next stage
+    size_t capacity{};
+    double throughput{};    // processed per second
+    std::chrono::microseconds avgLatency{};     // per value, without blocked
+    std::chrono::microseconds maxLatency{};
+    std::chrono::microseconds blocked{};        // waiting for a full queue
+};
+
+// the untyped part of a stage, runs the work on each thread,
+//   after the last thread is done the queues are closed.
+class PipelineStage
+{
+public:
+    PipelineStage(const std::string& name, uint32_t threads
+                , const std::function<void()>& close
+                , const std::function<size_t()>& queued = nullptr
+                , size_t capacity = 0u);
+    explicit PipelineStage(const PipelineStage& orig) = delete;
+    virtual ~PipelineStage() = default;
+
+    void start(const std::function<void()>& work);
+    void join();
+    void close();
+    // the time used for a value (without blocked)
+    void addProcessed(std::chrono::steady_clock::duration latency);
+    void addEmitted(std::chrono::steady_clock::duration blocked);
+    StageMetrics getMetrics() const;
+    uint32_t getThreads() const;
+private:
+    void run(const std::function<void()>& work);
+
+    std::string m_name;
+    uint32_t m_threads;
+    std::function<void()> m_close;
+    std::function<size_t()> m_queued;
+    size_t m_capacity;
+    std::vector<std::thread> m_workers;
+    std::atomic<uint32_t> m_running{};
+    std::atomic<uint64_t> m_processed{};
+    std::atomic<uint64_t> m_emitted{};
+    std::atomic<int64_t> m_sumLatency{};    // ns
+    std::atomic<int64_t> m_maxLatency{};
+    std::atomic<int64_t> m_blocked{};
+    std::atomic<int64_t> m_start{};         // steady ns
+    std::atomic<int64_t> m_end{};
+};
+
+// passes values to the next stage, waits while its queue is full,
+//   returns false if the pipeline was cancelled (stop producing).
+template <typename T>
+class PipelineEmitter
+{
+public:
+    PipelineEmitter(TQueueConcurrent<T>& queue, PipelineStage& stage, const CancellationToken& token
+                  , bool source = false)
+    : m_queue{queue}
+    , m_stage{stage}
+    , m_token{token}
+    , m_source{source}
+    , m_last{std::chrono::steady_clock::now()}
+    {
+    }
+    bool operator()(T value)
+    {
+        if (m_token.isCancelled()) {
+            return false;
+        }
+        auto start = std::chrono::steady_clock::now();
+        if (m_source) {     // the time to produce the value
+            m_stage.addProcessed(start - m_last);
+        }
+        bool pushed = m_queue.push(std::move(value));
+        m_last = std::chrono::steady_clock::now();
+        auto blocked = m_last - start;
+        m_blocked += blocked;
+        m_stage.addEmitted(blocked);
+        return pushed;
+    }
+    std::chrono::steady_clock::duration getBlocked() const
+    {
+        return m_blocked;
+    }
+    const CancellationToken& getToken() const
+    {
+        return m_token;
+    }
+private:
+    TQueueConcurrent<T>& m_queue;
+    PipelineStage& m_stage;
+    const CancellationToken& m_token;
+    const bool m_source;
+    std::chrono::steady_clock::time_point m_last;
+    std::chrono::steady_clock::duration m_blocked{};
+};
+
+template <typename T>
+class PipelineBuilder;
+
+class Pipeline
+{
+public:
+    explicit Pipeline(const CancellationToken& token);
+    explicit Pipeline(const Pipeline& orig) = delete;
+    // cancels if not waited for
+    virtual ~Pipeline();
+
+    static constexpr size_t DEFAULT_CAPACITY{16u};
+    static constexpr size_t POP_BATCH{8u};      // for single threaded stages
+
+    // the first stage, fun(PipelineEmitter<T>& emit) produces the values,
+    //   capacity limits the values waiting for the next stage.
+    template <typename T, typename F>
+    static PipelineBuilder<T> source(const std::string& name, F&& fun
+                                   , size_t capacity = DEFAULT_CAPACITY
+                                   , const CancellationToken& token = CancellationToken());
+
+    // wait for all stages, the first exception is rethrown
+    //   (a failure cancels the pipeline)
+    void wait();
+    void cancel();
+    bool isCancelled() const;
+    const CancellationToken& getToken() const;
+    std::vector<StageMetrics> getMetrics();
+
+    // the stage starts right away, the work runs on each of its threads
+    PipelineStage& start(std::unique_ptr<PipelineStage>&& stage, const std::function<void()>& work);
+private:
+    void failed(std::exception_ptr eptr);
+
+    CancellationToken m_token;
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<PipelineStage>> m_stages;
+    std::exception_ptr m_eptr;
+    bool m_waited{false};
+};
+
+// adds typed stages to a pipeline.
+//   Each thread uses a copy of the stage function,
+//   with threads > 1 the order of values is not kept.
+template <typename T>
+class PipelineBuilder
+{
+public:
+    PipelineBuilder(std::unique_ptr<Pipeline>&& pipeline, const std::shared_ptr<TQueueConcurrent<T>>& queue)
+    : m_pipeline{std::move(pipeline)}
+    , m_queue{queue}
+    {
+    }
+
+    // fun(T&& value, PipelineEmitter<O>& emit) may pass on any number of values
+    template <typename O, typename F>
+    PipelineBuilder<O> then(const std::string& name, F&& fun, uint32_t threads = 1u
+                          , size_t capacity = Pipeline::DEFAULT_CAPACITY)
+    {
+        auto output = std::make_shared<TQueueConcurrent<O>>(capacity);
+        auto stage = std::make_unique<PipelineStage>(name, threads
+                , [input = m_queue, output] {
+                    input->finish();    // a producer may wait for room
+                    output->finish();
+                }
+                , [output] {
+                    return output->size();
+                }
+                , capacity);
+        auto& stageRef = *stage;
+        auto& token = m_pipeline->getToken();
+        m_pipeline->start(std::move(stage)
+                , [input = m_queue, output, &stageRef, &token, fun, threads] () mutable {
+            PipelineEmitter<O> emit(*output, stageRef, token);
+            consume(*input, stageRef, token, threads, [&] (T&& value) {
+                auto blocked = emit.getBlocked();
+                fun(std::move(value), emit);
+                return emit.getBlocked() - blocked;
+            });
+        });
+        return PipelineBuilder<O>(std::move(m_pipeline), output);
+    }
+
+    // passes on the result of fun(T&& value) for each value
+    template <typename F>
+    auto map(const std::string& name, F&& fun, uint32_t threads = 1u
+           , size_t capacity = Pipeline::DEFAULT_CAPACITY)
+    {
+        using O = std::invoke_result_t<F, T&&>;
+        return then<O>(name, [fun] (T&& value, PipelineEmitter<O>& emit) mutable {
+            emit(fun(std::move(value)));
+        }, threads, capacity);
+    }
+
+    // the last stage, fun(T&& value)
+    template <typename F>
+    std::unique_ptr<Pipeline> sink(const std::string& name, F&& fun, uint32_t threads = 1u)
+    {
+        auto stage = std::make_unique<PipelineStage>(name, threads
+                , [input = m_queue] {
+                    input->finish();
+                });
+        auto& stageRef = *stage;
+        auto& token = m_pipeline->getToken();
+        m_pipeline->start(std::move(stage)
+                , [input = m_queue, &stageRef, &token, fun, threads] () mutable {
+            consume(*input, stageRef, token, threads, [&] (T&& value) {
+                fun(std::move(value));
+                return std::chrono::steady_clock::duration{};
+            });
+        });
+        return std::move(m_pipeline);
+    }
+
+private:
+    // process(T&&) returns the time blocked by the next stage
+    template <typename Process>
+    static void
+    consume(TQueueConcurrent<T>& input, PipelineStage& stage, const CancellationToken& token
+          , uint32_t threads, Process&& process)
+    {
+        // a batch would leave the other threads without work
+        const size_t batch = threads > 1u ? 1u : Pipeline::POP_BATCH;
+        while (true) {
+            auto values = input.pop_batch(batch);
+            if (values.empty()) {       // finished and drained
+                break;
+            }
+            for (auto& value : values) {
+                if (token.isCancelled()) {
+                    return;
+                }
+                auto start = std::chrono::steady_clock::now();
+                auto blocked = process(std::move(value));
+                stage.addProcessed(std::chrono::steady_clock::now() - start - blocked);
+            }
+        }
+    }
+
+    std::unique_ptr<Pipeline> m_pipeline;
+    std::shared_ptr<TQueueConcurrent<T>> m_queue;
+};
+
+template <typename T, typename F>
+PipelineBuilder<T>
+Pipeline::source(const std::string& name, F&& fun, size_t capacity, const CancellationToken& token)
+{
+    auto pipeline = std::make_unique<Pipeline>(token);
+    auto output = std::make_shared<TQueueConcurrent<T>>(capacity);
+    auto stage = std::make_unique<PipelineStage>(name, 1u
+            , [output] {
+                output->finish();
+            }
+            , [output] {
+                return output->size();
+            }
+            , capacity);
+    auto& stageRef = *stage;
+    auto& pipelineToken = pipeline->getToken();
+    pipeline->start(std::move(stage)
+            , [output, &stageRef, &pipelineToken, fun] () mutable {
+        PipelineEmitter<T> emit(*output, stageRef, pipelineToken, true);
+        fun(emit);
+    });
+    return PipelineBuilder<T>(std::move(pipeline), output);
+}
+
+} /* namespace psc::util */
@@ -0,0 +1,59 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gtkmm.h>
+#include <set>
+#include <string>
+
+enum class ScanMode
+{
+      Fast      // use extension and fast-content-type, sniff only if undecided
+    , Sniff     // read the content-type for each file
+};
+
+enum class Readable
+{
+      Yes
+    , No
+    , Unknown   // requires looking into the file
+};
+
+// the readable pixbuf formats, collected once
+class PixbufFormats
+{
+public:
+    explicit PixbufFormats(const PixbufFormats& orig) = delete;
+    virtual ~PixbufFormats() = default;
+
+    static const PixbufFormats& get();
+    bool isReadableMime(const Glib::ustring& mime) const;
+    bool isReadableExtension(const std::string& ext) const;
+    // decide by name and fast-content-type (the later may be empty)
+    Readable classify(const std::string& name, const Glib::ustring& fastContentType) const;
+    // classify and if undecided use the content-type (reading the file)
+    bool isReadable(const Glib::RefPtr<Gio::File>& file, ScanMode scanMode = ScanMode::Fast) const;
+    static constexpr auto FAST_SCAN_ATTRIBUTES{"standard::name,standard::type,standard::fast-content-type"};
+    static constexpr auto SNIFF_SCAN_ATTRIBUTES{"standard::name,standard::type,standard::content-type"};
+private:
+    PixbufFormats();
+
+    std::set<Glib::ustring> m_mimeTypes;
+    std::set<std::string> m_extensions;   // lowercase
+};
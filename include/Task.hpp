@@ -0,0 +1,347 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <giomm.h>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Executor.hpp"
+
+namespace psc::util {
+
+template <typename T>
+class Task;
+
+template <typename T>
+class TaskPromiseBase
+{
+public:
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+    // continue the awaiting coroutine (if any)
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+        {
+            auto continuation = handle.promise().m_continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept
+        {
+        }
+    };
+    FinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+    void unhandled_exception()
+    {
+        m_eptr = std::current_exception();
+    }
+    std::coroutine_handle<> m_continuation;
+    std::exception_ptr m_eptr;
+};
+
+template <typename T>
+class TaskPromise
+: public TaskPromiseBase<T>
+{
+public:
+    Task<T> get_return_object();
+    template <typename V>
+    void return_value(V&& value)
+    {
+        m_value.emplace(std::forward<V>(value));
+    }
+    T result()
+    {
+        if (this->m_eptr) {
+            std::rethrow_exception(this->m_eptr);
+        }
+        return std::move(*m_value);
+    }
+private:
+    std::optional<T> m_value;
+};
+
+template <>
+class TaskPromise<void>
+: public TaskPromiseBase<void>
+{
+public:
+    Task<void> get_return_object();
+    void return_void()
+    {
+    }
+    void result()
+    {
+        if (m_eptr) {
+            std::rethrow_exception(m_eptr);
+        }
+    }
+};
+
+// a lazy coroutine, it runs when awaited (or started with spawn).
+//   Write sequential code that switches threads with co_await resume_on_pool()
+//   and co_await resume_on_main(), or waits for gio operations with gio_async.
+template <typename T = void>
+class [[nodiscard]] Task
+{
+public:
+    using promise_type = TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+    : m_handle{handle}
+    {
+    }
+    Task(Task&& other) noexcept
+    : m_handle{std::exchange(other.m_handle, {})}
+    {
+    }
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    explicit Task(const Task& orig) = delete;
+    ~Task()
+    {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept
+    {
+        return !m_handle || m_handle.done();
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().m_continuation = awaiting;
+        return m_handle;
+    }
+    T await_resume()
+    {
+        return m_handle.promise().result();
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+template <typename T>
+Task<T>
+TaskPromise<T>::get_return_object()
+{
+    return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void>
+TaskPromise<void>::get_return_object()
+{
+    return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+// the coroutine for spawn, it runs eagerly and cleans up itself
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object() noexcept
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void() noexcept
+        {
+        }
+        void unhandled_exception() noexcept
+        {
+            std::terminate();   // spawn catches everything
+        }
+    };
+};
+
+using SlotFailed = std::function<void(std::exception_ptr)>;
+
+// start a task without awaiting it e.g. from a signal handler,
+//   done gets the result, failed the exception (both are called where the task ended).
+template <typename T>
+Detached
+spawn(Task<T> task, std::type_identity_t<std::function<void(T)>> done, SlotFailed failed = {})
+{
+    std::exception_ptr eptr;
+    try {
+        auto result = co_await task;
+        if (done) {
+            done(std::move(result));
+        }
+    }
+    catch (...) {
+        eptr = std::current_exception();
+    }
+    if (eptr && failed) {
+        failed(eptr);
+    }
+}
+
+inline Detached
+spawn(Task<void> task, std::function<void()> done = {}, SlotFailed failed = {})
+{
+    std::exception_ptr eptr;
+    try {
+        co_await task;
+        if (done) {
+            done();
+        }
+    }
+    catch (...) {
+        eptr = std::current_exception();
+    }
+    if (eptr && failed) {
+        failed(eptr);
+    }
+}
+
+// throws a Gio::Error CANCELLED if the cancellable was triggered
+void check_cancelled(const Glib::RefPtr<Gio::Cancellable>& cancellable);
+
+// continue on a executor thread
+class PoolAwaiter
+{
+public:
+    PoolAwaiter(Priority priority, const Glib::RefPtr<Gio::Cancellable>& cancellable);
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume();
+private:
+    Priority m_priority;
+    Glib::RefPtr<Gio::Cancellable> m_cancellable;
+};
+
+// continue on the thread running the default main context (gtk)
+class MainAwaiter
+{
+public:
+    explicit MainAwaiter(const Glib::RefPtr<Gio::Cancellable>& cancellable);
+    bool await_ready() const;
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume();
+private:
+    Glib::RefPtr<Gio::Cancellable> m_cancellable;
+};
+
+PoolAwaiter resume_on_pool(Priority priority = Priority::Background
+                         , const Glib::RefPtr<Gio::Cancellable>& cancellable = {});
+MainAwaiter resume_on_main(const Glib::RefPtr<Gio::Cancellable>& cancellable = {});
+
+// await a gio async operation, start gets the slot and the cancellable
+//   to pass on to the ..._async call, finish calls the matching ..._finish.
+//   The coroutine continues on the main context
+//   (as gio reports there, if not started from a thread with its own context).
+template <typename R>
+class GioAwaiter
+{
+public:
+    using SlotStart = std::function<void(const Gio::SlotAsyncReady&, const Glib::RefPtr<Gio::Cancellable>&)>;
+    using SlotFinish = std::function<R(const Glib::RefPtr<Gio::AsyncResult>&)>;
+
+    GioAwaiter(const SlotStart& start, const SlotFinish& finish, const Glib::RefPtr<Gio::Cancellable>& cancellable)
+    : m_start{start}
+    , m_finish{finish}
+    , m_cancellable{cancellable}
+    {
+    }
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        m_start([this, handle] (Glib::RefPtr<Gio::AsyncResult>& result) {
+            try {
+                m_result.emplace(m_finish(result));
+            }
+            catch (...) {
+                m_eptr = std::current_exception();
+            }
+            handle.resume();
+        }, m_cancellable);
+    }
+    R await_resume()
+    {
+        if (m_eptr) {
+            std::rethrow_exception(m_eptr);
+        }
+        return std::move(*m_result);
+    }
+private:
+    SlotStart m_start;
+    SlotFinish m_finish;
+    Glib::RefPtr<Gio::Cancellable> m_cancellable;
+    std::optional<R> m_result;
+    std::exception_ptr m_eptr;
+};
+
+template <typename R>
+GioAwaiter<R>
+gio_async(const typename GioAwaiter<R>::SlotStart& start
+        , const typename GioAwaiter<R>::SlotFinish& finish
+        , const Glib::RefPtr<Gio::Cancellable>& cancellable = {})
+{
+    return GioAwaiter<R>(start, finish, cancellable);
+}
+
+// the usual operations
+Task<std::string> load_contents(Glib::RefPtr<Gio::File> file
+                              , Glib::RefPtr<Gio::Cancellable> cancellable = {});
+Task<std::vector<Glib::RefPtr<Gio::FileInfo>>> enumerate_children(Glib::RefPtr<Gio::File> dir
+                              , std::string attributes
+                              , Glib::RefPtr<Gio::Cancellable> cancellable = {});
+
+} // namespace psc::util
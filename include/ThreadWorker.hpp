@@ -24,6 +24,12 @@
 #include <chrono>
 #include <queue>
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+#include "Executor.hpp"
 
 
 // this queue is intended to be used to
@@ -53,28 +59,45 @@ public:
         } );
     }
 
+    /** @brief  As RingQueue::try_push_back, this queue is unbounded
+                so it never waits and the stop condition is not needed.
+    **/
+    template<typename P>
+    bool try_push_back(T&& value, P&&)
+    {
+        push_back(std::move(value));
+        return true;
+    }
+
+    // nothing waits here
+    void wakeProducers()
+    {
+    }
+
     /** @brief  Returns the the queued elements with out.
+                If this returns false, all elements added before finish are included.
     **/
     bool pop_front(std::vector<T>& out) noexcept
     {
-        if (!m_collection.empty()) {
-            std::unique_lock<std::mutex> lock{m_mutex};
-            out.reserve(m_collection.size());
-            while(!m_collection.empty()) {
-               out.emplace_back(std::move(m_collection.front()));
-               m_collection.pop_front();
-            }
-            lock.unlock();
+        std::unique_lock<std::mutex> lock{m_mutex};
+        bool active = m_active;
+        out.reserve(m_collection.size());
+        while(!m_collection.empty()) {
+           out.emplace_back(std::move(m_collection.front()));
+           m_collection.pop_front();
         }
-        return m_active;
+        lock.unlock();
+        return active;
     }
 
     void finish()
     {
+        std::lock_guard<std::mutex> lock{m_mutex};
         m_active = false;
     }
     bool isActive()
     {
+        std::lock_guard<std::mutex> lock{m_mutex};
         return m_active;
     }
 private:
@@ -99,7 +122,162 @@ private:
 
 };
 
-template <typename I, typename T>
+// lock free alternative to ConcurrentQueue, for workers that notify often.
+//   Multiple producers, but only a single consumer (calling pop_front).
+//   The size is bounded, a producer waits while the queue is full.
+//   (based on the bounded queue by D. Vyukov,
+//    each cell has a sequence that tells whose turn it is)
+template< typename T, size_t Capacity = 1024u >
+class RingQueue
+{
+public:
+    static_assert(Capacity >= 2u && (Capacity & (Capacity - 1u)) == 0u, "Capacity has to be a power of 2");
+
+    RingQueue()
+    : m_cells(Capacity)
+    {
+        for (size_t i = 0; i < Capacity; ++i) {
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+    explicit RingQueue(const RingQueue& orig) = delete;
+    virtual ~RingQueue() = default;
+
+    template<typename... Args>
+    void emplace_back( Args&&... args )
+    {
+        push_back(T(std::forward<Args>(args)...));
+    }
+
+    /** @brief  Adds the value, waits while the queue is full.
+                Returns the sequence number of the value (counting from 0),
+                the consumer gets the values in this order.
+    **/
+    size_t push_back(T&& value)
+    {
+        size_t pos{};
+        push_back(std::move(value), pos, [] {
+            return false;
+        });
+        return pos;
+    }
+
+    size_t push_back(const T& value)
+    {
+        return push_back(T(value));
+    }
+
+    /** @brief  Adds the value as push_back, but while the queue is full
+                stop is checked (again after each wakeProducers),
+                returns false if the value was not added as stop returned true.
+    **/
+    template<typename P>
+    bool push_back(T&& value, size_t& pos, P&& stop)
+    {
+        while (true) {
+            auto space = m_space.load(std::memory_order_acquire);
+            if (try_push(value, pos)) {
+                return true;
+            }
+            if (stop()) {
+                return false;
+            }
+            // full, wait for the consumer to make some room
+            m_space.wait(space, std::memory_order_acquire);
+        }
+    }
+
+    template<typename P>
+    bool try_push_back(T&& value, P&& stop)
+    {
+        size_t pos;
+        return push_back(std::move(value), pos, std::forward<P>(stop));
+    }
+
+    // the producers waiting for room check their stop condition again
+    void wakeProducers()
+    {
+        m_space.fetch_add(1u, std::memory_order_release);
+        m_space.notify_all();
+    }
+
+    // the number of values claimed by producers (not necessarily complete)
+    size_t getEnqueued()
+    {
+        return m_enqueuePos.load(std::memory_order_acquire);
+    }
+
+    /** @brief  Returns the the queued elements with out.
+                If this returns false, all elements added before finish are included.
+    **/
+    bool pop_front(std::vector<T>& out) noexcept
+    {
+        bool active = m_active.load(std::memory_order_acquire);
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        auto start = pos;
+        while (true) {
+            auto& cell = m_cells[pos & MASK];
+            if (cell.seq.load(std::memory_order_acquire) != pos + 1u) {
+                break;      // empty, or the producer is not done
+            }
+            out.emplace_back(std::move(cell.value));
+            cell.seq.store(pos + Capacity, std::memory_order_release);
+            ++pos;
+        }
+        if (pos != start) {
+            m_dequeuePos.store(pos, std::memory_order_release);
+            wakeProducers();
+        }
+        return active;
+    }
+
+    void finish()
+    {
+        m_active.store(false, std::memory_order_release);
+    }
+    bool isActive()
+    {
+        return m_active.load(std::memory_order_acquire);
+    }
+private:
+    bool try_push(T& value, size_t& pos)
+    {
+        pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            auto& cell = m_cells[pos & MASK];
+            auto seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.seq.store(pos + 1u, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {    // full
+                return false;
+            }
+            else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static constexpr size_t MASK{Capacity - 1u};
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T value;
+    };
+    std::vector<Cell> m_cells;
+    alignas(64) std::atomic<size_t> m_enqueuePos{0u};
+    alignas(64) std::atomic<size_t> m_dequeuePos{0u};
+    std::atomic<uint32_t> m_space{0u};     // changed when the producers shall look again
+    std::atomic<bool> m_active{true};
+};
+
+// the queue Q may be ConcurrentQueue<I> or RingQueue<I>
+template <typename I, typename T, typename Q = ConcurrentQueue<I>>
 class ThreadWorker
 {
 public:
@@ -110,17 +288,58 @@ public:
                 sigc::mem_fun(*this, &ThreadWorker::emited));
     }
     explicit ThreadWorker(const ThreadWorker& orig) = delete;
-    virtual ~ThreadWorker() = default;
+    virtual ~ThreadWorker()
+    {
+        if (m_future.valid()) {     // as we are referenced by the task
+            cancel();               // the result is of no use anymore, and no one reads the queue
+            m_future.wait();
+        }
+    }
 
+    static constexpr uint32_t DEFAULT_PROGRESS_RATE{30u};
+    static constexpr double NO_PROGRESS{-1.0};
+
+    // ask doInBackground to stop (it has to check isCancelled),
+    //   pending values are dropped, done is called as usual.
+    void cancel()
+    {
+        m_token.cancel();
+        m_queue.wakeProducers();    // a notify waiting for room shall drop its value
+    }
+    bool isCancelled() const
+    {
+        return m_token.isCancelled();
+    }
+    const psc::util::CancellationToken& getToken() const
+    {
+        return m_token;
+    }
+    // the onProgress calls per second (the latest value is delivered)
+    void setProgressRate(uint32_t perSecond)
+    {
+        m_progressInterval.store(std::chrono::nanoseconds(std::chrono::seconds(1)).count() / std::max(1u, perSecond)
+                               , std::memory_order_relaxed);
+    }
+    // run doInBackground on its own thread, so it may block (e.g. reading files)
     void execute()
     {
         //std::cout << "ThreadWorker::execute" << std::endl;
         m_future = std::async(std::launch::async, &ThreadWorker::run, this);
     }
+    // run doInBackground on the shared executor,
+    //   use this only for short computations that do not wait for anything,
+    //   otherwise they would occupy the threads needed for e.g. the visible image
+    void execute(psc::util::Priority priority)
+    {
+        m_future = psc::util::Executor::get().submit(priority, [this] {
+            run();
+        });
+    }
     void run()
     {
         try {
             //std::cout << "ThreadWorker::run " << this << std::endl;
+            m_token.throwIfCancelled();     // e.g. cancelled while queued
             m_t = doInBackground();
         }
         catch (...) {
@@ -133,14 +352,19 @@ public:
     }
     void emit(bool last = false)
     {
-        using namespace std::chrono_literals; // ns, us, ms, s, h, etc.
-
-        // since we run into trouble if dispatched will be used while active
-        //   or we leave out the final action have to go thru this
-        if (last) {
-            while (m_pending) {
-                std::this_thread::sleep_for(100ms);
+        // handshake with emited: a pending dispatch that has not yet
+        //   started is sure to see the queue content and the finish,
+        //   otherwise we dispatch again, so no one has to wait here
+        if (!last) {
+            // the fences order our queueing and the reset in emited,
+            //   so if we still see pending the dispatch will get our element
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_pending.load(std::memory_order_relaxed)) {
+                return;
             }
+        }
+        std::lock_guard<std::mutex> lock{m_pendingMutex};
+        if (last) {
             m_queue.finish();
         }
         if (!m_pending) {
@@ -148,25 +372,57 @@ public:
             m_notify.emit();
         }
     }
+    // report progress from doInBackground (e.g. 0..1),
+    //   the updates are coalesced so onProgress is called at most with the progress rate
+    void progress(double value)
+    {
+        m_progress.store(value, std::memory_order_relaxed);
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        auto last = m_progressLast.load(std::memory_order_relaxed);
+        if (now - last >= m_progressInterval.load(std::memory_order_relaxed)
+         && m_progressLast.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+            emit();
+        }
+    }
     void notify(I i)
     {
         //std::cout << "ThreadWorker::notify " << std::boolalpha << m_queue.isActive() << std::endl;
-        m_queue.emplace_back(i);
+        // once cancelled the values are dropped anyway, and the gtk thread may not read anymore
+        //   (e.g. waiting for us in the destructor), so don't wait for room
+        if (!m_queue.try_push_back(std::move(i), [this] {
+                return isCancelled();
+            })) {
+            return;
+        }
         emit();
     }
     void emited()
     {
-        std::vector<I> out;
-        bool active = m_queue.pop_front(out);
+        {
+            // reset before reading, anything added later will dispatch again
+            std::lock_guard<std::mutex> lock{m_pendingMutex};
+            m_pending = false;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool active = m_queue.pop_front(m_out);
         //std::cout << "ThreadWorker::emited active " << std::boolalpha << active << std::endl;
-        if (!out.empty()) {
-            process(out);
+        if (!m_out.empty()) {
+            if (!isCancelled()) {
+                process(m_out);
+            }
+            m_out.clear();      // keep the capacity for the next batch
+        }
+        auto progress = m_progress.load(std::memory_order_relaxed);
+        if (progress != m_progressShown
+         && !isCancelled()) {
+            m_progressShown = progress;
+            onProgress(progress);
         }
         if (!active && !m_completed) {
             m_completed = true;
             completed();
         }
-        m_pending = false;
         //std::cout << "ThreadWorker::emited done " << std::boolalpha << m_queue.isActive() << std::endl;
     }
     void completed()
@@ -191,13 +447,24 @@ protected:
     virtual T doInBackground() = 0;
     virtual void process(const std::vector<I>& out) = 0;
     virtual void done() = 0;
+    // called on the gtk thread with the latest progress
+    virtual void onProgress(double)
+    {
+    }
 private:
-    ConcurrentQueue<I> m_queue;
+    Q m_queue;
+    std::vector<I> m_out;
     Glib::Dispatcher m_notify;
     std::future<void> m_future;
     T m_t;
     std::exception_ptr m_eptr;
-    volatile std::atomic<bool> m_completed{false};
-    volatile std::atomic<bool> m_pending{false};
+    std::atomic<bool> m_completed{false};
+    std::mutex m_pendingMutex;
+    std::atomic<bool> m_pending{false};      // set under m_pendingMutex
+    psc::util::CancellationToken m_token;
+    std::atomic<double> m_progress{NO_PROGRESS};
+    double m_progressShown{NO_PROGRESS};
+    std::atomic<int64_t> m_progressLast{0};   // steady ns of last emit
+    std::atomic<int64_t> m_progressInterval{std::chrono::nanoseconds(std::chrono::seconds(1)).count() / DEFAULT_PROGRESS_RATE};   // set from any thread
 };
 
@@ -0,0 +1,103 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gtkmm.h>
+#include <list>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+// sizes as defined by the freedesktop thumbnail spec
+enum class ThumbnailSize
+{
+      Normal = 128
+    , Large = 256
+};
+
+struct ThumbnailRequest
+{
+    Glib::RefPtr<Gio::File> file;
+    std::string uri;
+    Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+};
+
+// delivers thumbnails, prefers the ones in ~/.cache/thumbnails,
+//   on a miss they will be created in background (and stored there).
+//   Create and use from the gtk thread, the slots will be called from there.
+//   The most recent requests are served first, if more than maxQueued
+//   are waiting the oldest are dropped (e.g. scrolled out of view),
+//   their slots are not called, request them again if still needed.
+class ThumbnailService
+{
+public:
+    using SlotThumbnail = sigc::slot<void, const Glib::RefPtr<Gio::File>&, const Glib::RefPtr<Gdk::Pixbuf>&>;
+
+    ThumbnailService(ThumbnailSize size = ThumbnailSize::Normal
+                    , uint32_t threads = DEFAULT_THREADS
+                    , size_t cacheSize = DEFAULT_CACHE_SIZE
+                    , size_t maxQueued = DEFAULT_MAX_QUEUED);
+    explicit ThumbnailService(const ThumbnailService& orig) = delete;
+    virtual ~ThumbnailService();
+
+    // get thumbnail, if it is in memory the slot is called immediately,
+    //   otherwise when it becomes available (the pixbuf may be empty if the file is unreadable)
+    void request(const Glib::RefPtr<Gio::File>& file, const SlotThumbnail& slot);
+    // only look into memory
+    Glib::RefPtr<Gdk::Pixbuf> lookup(const Glib::RefPtr<Gio::File>& file);
+    ThumbnailSize getSize();
+
+    // path as the spec requires e.g. ~/.cache/thumbnails/normal/<md5 of uri>.png
+    static std::string getThumbnailPath(const std::string& uri, ThumbnailSize size);
+    static constexpr uint32_t DEFAULT_THREADS{2u};
+    static constexpr size_t DEFAULT_CACHE_SIZE{512u};
+    static constexpr size_t DEFAULT_MAX_QUEUED{128u};
+protected:
+    void run();
+    std::shared_ptr<ThumbnailRequest> nextRequest();
+    Glib::RefPtr<Gdk::Pixbuf> loadThumbnail(const std::shared_ptr<ThumbnailRequest>& request);
+    Glib::RefPtr<Gdk::Pixbuf> readValid(const std::string& path, const std::string& uri, guint64 mtime);
+    Glib::RefPtr<Gdk::Pixbuf> createThumbnail(const std::shared_ptr<ThumbnailRequest>& request, guint64 mtime);
+    void on_done();
+    void cache(const std::string& uri, const Glib::RefPtr<Gdk::Pixbuf>& pixbuf);
+    static const char* getSizeName(ThumbnailSize size);
+
+private:
+    ThumbnailSize m_size;
+    size_t m_cacheSize;
+    size_t m_maxQueued;
+    std::mutex m_requestMutex;
+    std::condition_variable m_requestCond;
+    std::deque<std::shared_ptr<ThumbnailRequest>> m_requests;
+    bool m_active{true};
+    std::vector<std::thread> m_threads;
+    Glib::Dispatcher m_dispatcher;
+    std::mutex m_doneMutex;
+    std::vector<std::shared_ptr<ThumbnailRequest>> m_done;
+    // the following are only used from the gtk thread
+    std::map<std::string, std::vector<SlotThumbnail>> m_pending;
+    using LruList = std::list<std::pair<std::string, Glib::RefPtr<Gdk::Pixbuf>>>;
+    LruList m_lru;
+    std::unordered_map<std::string, LruList::iterator> m_lruIndex;
+};
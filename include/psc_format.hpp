@@ -36,6 +36,7 @@ namespace psc {
 #if __cplusplus >= 202002L
 namespace fmt {
     using std::format;
+    using std::format_string;
     using std::formatter;
     using std::format_context;
     using std::vformat;
@@ -19,6 +19,7 @@
 #include <iostream>
 
 #include "BinModel.hpp"
+#include "Parallel.hpp"
 
 BinModel::BinModel(Glib::Dispatcher& binDispatcher, Glib::RefPtr<Gdk::Pixbuf>& pixbuf)
 : m_binDispatcher{binDispatcher}
@@ -58,17 +59,36 @@ BinModel::readPixbuf()
     if (m_pixbuf->get_bits_per_sample() != EXP_BITS_PER_SAMPLE) {
         std::cerr << "BinModel::readPixbuf expecting 8bits per sample is " << m_pixbuf->get_bits_per_sample() << " continue (may display invalid results)." << std::endl;
     }
-    uint32_t nChannels = m_pixbuf->get_n_channels();
-    uint32_t width = m_pixbuf->get_width();
-    for (int32_t y = 0; y < m_pixbuf->get_height(); ++y) {
-        guint8* a = m_pixbuf->get_pixels() + y * m_pixbuf->get_rowstride();
-        for (uint32_t x = 0; x < width; ++x) {
-            for (uint32_t c = 0; c < nChannels; ++c) {
-                if (c < N_COL) {
-                    ++m_bin[*(a + c)][c];
+    const uint32_t nChannels = m_pixbuf->get_n_channels();
+    const uint32_t width = m_pixbuf->get_width();
+    const guint8* pixels = m_pixbuf->get_pixels();
+    const size_t rowstride = m_pixbuf->get_rowstride();
+    // count rows in parallel, each participant into its own bins
+    auto bins = psc::util::parallel_reduce(0u, static_cast<size_t>(m_pixbuf->get_height()), PARALLEL_ROWS, Bins{}
+        , [&] (size_t lo, size_t hi, Bins& partial) {
+            for (size_t y = lo; y < hi; ++y) {
+                const guint8* a = pixels + y * rowstride;
+                for (uint32_t x = 0; x < width; ++x) {
+                    for (uint32_t c = 0; c < nChannels; ++c) {
+                        if (c < N_COL) {
+                            ++partial[*(a + c)][c];
+                        }
+                    }
+                    a += nChannels;
                 }
             }
-            a += m_pixbuf->get_n_channels();
+        }
+        , [] (Bins& result, const Bins& partial) {
+            for (uint32_t c = 0; c < N_BIN; ++c) {
+                for (uint32_t rgb = 0; rgb < N_COL; ++rgb) {
+                    result[c][rgb] += partial[c][rgb];
+                }
+            }
+        }
+        , psc::util::Priority::Histogram);
+    for (uint32_t c = 0; c < N_BIN; ++c) {
+        for (uint32_t rgb = 0; rgb < N_COL; ++rgb) {
+            m_bin[c][rgb] = bins[c][rgb];
         }
     }
     m_pixbuf.reset();       // reset reference as we don't need it anymore (clear/release is a totally different story!)
@@ -40,7 +40,14 @@ BinView::setPixbuf(Glib::RefPtr<DisplayImage>& displayImage)
 {
 	Glib::RefPtr<Gdk::Pixbuf> pixbuf = displayImage->getPixbuf();
     m_model = std::make_shared<BinModel>(m_binDispatcher, pixbuf);
-    m_pixelReader = std::async(std::launch::async, &BinModel::readPixbuf, m_model);
+    // if replaced before it started there is no need to read it
+    std::weak_ptr<BinModel> model{m_model};
+    m_pixelReader = m_reads.submit(psc::util::Priority::Histogram, [model] {
+        auto binModel = model.lock();
+        if (binModel) {
+            binModel->readPixbuf();
+        }
+    });
 }
 
 
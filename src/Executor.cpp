@@ -0,0 +1,157 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "Executor.hpp"
+
+namespace psc::util {
+
+uint32_t Executor::m_configuredThreads{};
+
+Executor::Executor(uint32_t threads)
+{
+    threads = std::max(1u, threads);
+    m_threads.reserve(threads);
+    for (uint32_t i = 0; i < threads; ++i) {
+        m_threads.emplace_back(std::thread(&Executor::run, this));
+    }
+}
+
+Executor::~Executor()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_active = false;
+    }
+    m_condTask.notify_all();
+    for (auto& thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+Executor&
+Executor::get()
+{
+    // leaked, a static would run the queued tasks during the static destruction
+    static Executor* executor = new Executor(m_configuredThreads > 0u
+                                            ? m_configuredThreads
+                                            : defaultThreads());
+    return *executor;
+}
+
+void
+Executor::configure(uint32_t threads)
+{
+    m_configuredThreads = threads;
+}
+
+uint32_t
+Executor::defaultThreads()
+{
+    return std::max(2u, std::thread::hardware_concurrency());
+}
+
+uint32_t
+Executor::getThreads() const
+{
+    return static_cast<uint32_t>(m_threads.size());
+}
+
+void
+Executor::enqueue(Priority priority, std::function<void()>&& fun)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_tasks.emplace(Task{priority, m_seq++, std::chrono::steady_clock::now(), std::move(fun)});
+        m_maxQueued = std::max(m_maxQueued, m_tasks.size());
+    }
+    m_condTask.notify_one();
+}
+
+void
+Executor::run()
+{
+    while (true) {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_condTask.wait(lock, [this] {
+            return !m_tasks.empty() || !m_active;
+        });
+        if (m_tasks.empty()) {  // finished, and all done
+            break;
+        }
+        // top is const, but the task gets removed anyway
+        auto task = std::move(const_cast<Task&>(m_tasks.top()));
+        m_tasks.pop();
+        auto latency = std::chrono::steady_clock::now() - task.submitted;
+        m_sumLatency += latency;
+        m_maxLatency = std::max(m_maxLatency, latency);
+        ++m_running;
+        lock.unlock();
+        task.fun();     // packaged_task keeps exceptions
+        task.fun = nullptr;     // release captures outside the lock
+        lock.lock();
+        --m_running;
+        ++m_completed;
+    }
+}
+
+ExecutorMetrics
+Executor::getMetrics()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    ExecutorMetrics metrics;
+    metrics.threads = getThreads();
+    metrics.running = m_running;
+    metrics.queued = m_tasks.size();
+    metrics.maxQueued = m_maxQueued;
+    metrics.completed = m_completed;
+    auto started = m_completed + m_running;
+    if (started > 0u) {
+        metrics.avgLatency = std::chrono::duration_cast<std::chrono::microseconds>(m_sumLatency / started);
+    }
+    metrics.maxLatency = std::chrono::duration_cast<std::chrono::microseconds>(m_maxLatency);
+    return metrics;
+}
+
+
+TaskGroup::~TaskGroup()
+{
+    wait();
+}
+
+void
+TaskGroup::wait()
+{
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_condDone.wait(lock, [this] {
+        return m_pending == 0u;
+    });
+}
+
+void
+TaskGroup::finished()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    --m_pending;
+    m_condDone.notify_all();
+}
+
+} // namespace psc::util
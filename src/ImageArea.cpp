@@ -38,15 +38,21 @@ ImageArea::ImageArea(BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>&
 }
 
 
+ImageArea::~ImageArea()
+{
+    ++m_loadGeneration;     // skip what is still queued
+    m_loads.wait();
+}
+
 Glib::RefPtr<Gdk::Pixbuf>
-ImageArea::readPicture()
+ImageArea::readPicture(const Glib::RefPtr<Gio::File>& file, uint64_t generation)
 {
-    finally notify_done([&] {
-        m_drawDispatcher.emit();
-    });
     Glib::RefPtr<Gdk::Pixbuf> pixbuf ;
+    if (generation != m_loadGeneration) {   // navigated on in the meantime
+        return pixbuf;
+    }
     try {
-        pixbuf = Gdk::Pixbuf::create_from_file(m_file->get_path());
+        pixbuf = Gdk::Pixbuf::create_from_file(file->get_path());
     }
     catch (const Glib::Exception& ex) {
         m_appSupport.showError(ex.what());  // for glib:error what seems sufficient
@@ -54,12 +60,29 @@ ImageArea::readPicture()
     return pixbuf;
 }
 
+void
+ImageArea::loaded(const Glib::RefPtr<Gdk::Pixbuf>& pixbuf, uint64_t generation)
+{
+    if (generation != m_loadGeneration) {   // outdated, no need to wake the gui
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock{m_loadedMutex};
+        m_loaded = pixbuf;
+        m_loadedGeneration = generation;
+    }
+    m_drawDispatcher.emit();    // the result is available now
+}
+
 void
 ImageArea::setFile(const Glib::RefPtr<Gio::File> file)
 {
     m_file = file;
     m_displayImage.clear();       // remove previous reference, matters if load will not succeed
-    m_pictureReader = std::async(std::launch::async, &ImageArea::readPicture, this);
+    auto generation = ++m_loadGeneration;
+    m_loads.submit(psc::util::Priority::Visible, [this, file, generation] {
+        loaded(readPicture(file, generation), generation);
+    });
 }
 
 Glib::RefPtr<DisplayImage>
@@ -124,8 +147,18 @@ ImageArea::calculateView()
 void
 ImageArea::onNotifyLoad()
 {
+    Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+    {
+        std::lock_guard<std::mutex> lock{m_loadedMutex};
+        // a load may have been outdated by the time we get here, wait for the current
+        if (m_loadedGeneration == 0
+         || m_loadedGeneration != m_loadGeneration) {
+            return;
+        }
+        pixbuf = std::move(m_loaded);
+        m_loadedGeneration = 0;     // taken
+    }
     try {
-        Glib::RefPtr<Gdk::Pixbuf> pixbuf = m_pictureReader.get();
   		Glib::RefPtr<DisplayImage> displ = DisplayImage::create(pixbuf);
         setPixbuf(displ);
     }
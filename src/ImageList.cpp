@@ -32,6 +32,11 @@ ImageList::ImageList()
 {
 }
 
+ImageList::~ImageList()
+{
+    cancelQuery();
+}
+
 
 // Attributes
 //File space2001.jpg type 1
@@ -82,12 +87,65 @@ void
 ImageList::fillList(const Glib::RefPtr<Gio::File> file)
 {
     clear();
-	auto chlds = appendList("File", "");
+    Glib::RefPtr<Gio::FileInfo> info = file->query_info(FILE_ATTRIBUTES);
+    fillList(file, info);
+}
+
+void
+ImageList::cancelQuery()
+{
+    if (m_cancellable) {
+        m_cancellable->cancel();
+        m_cancellable.reset();
+    }
+}
+
+void
+ImageList::queryAsync(const Glib::RefPtr<Gio::File>& file, const SlotInfo& slot)
+{
+    cancelQuery();
+    auto cancellable = Gio::Cancellable::create();
+    m_cancellable = cancellable;
+    file->query_info_async(
+        [file, cancellable, slot] (Glib::RefPtr<Gio::AsyncResult>& result) {
+            Glib::RefPtr<Gio::FileInfo> info;
+            try {
+                info = file->query_info_finish(result);
+            }
+            catch (const Glib::Error& ex) {
+                if (!cancellable->is_cancelled()) {
+                    std::cerr << "ImageList::queryAsync " << file->get_path() << " " << ex.what() << std::endl;
+                }
+                return;
+            }
+            if (!cancellable->is_cancelled()) {     // dont touch anything if we were cancelled
+                slot(file, info);
+            }
+        }
+        , cancellable
+        , FILE_ATTRIBUTES);
+}
+
+void
+ImageList::fillDetached(const Glib::RefPtr<Gtk::TreeView>& view
+                      , const Glib::RefPtr<ImageList>& list
+                      , const std::function<void()>& fill)
+{
+    view->unset_model();
+    fill();
+    view->set_model(list);
+    view->expand_all();
+}
+
+void
+ImageList::fillList(const Glib::RefPtr<Gio::File>& file, const Glib::RefPtr<Gio::FileInfo>& info)
+{
+    // keep file infos in front (the image infos may be already there)
+	auto chlds = prependList("File", "");
 
     Glib::ustring path(file->get_parent()->get_path());
     appendList(chlds, "Path", path);
 
-    Glib::RefPtr<Gio::FileInfo> info = file->query_info("standard::*,time::*,owner::*,unix::*,metadata::*");
     Glib::ustring name = info->get_display_name();
     appendList(chlds, "Name", name);
 
@@ -255,6 +313,14 @@ ImageList::appendList(const char *name, const Glib::ustring& value)
 	return i;
 }
 
+Gtk::TreeIter
+ImageList::prependList(const char *name, const Glib::ustring& value)
+{
+    auto i = prepend();
+	setValues(i, name, value);
+	return i;
+}
+
 Gtk::TreeIter
 ImageList::appendList(Gtk::TreeIter& node, const char *name, const Glib::ustring& value)
 {
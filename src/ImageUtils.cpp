@@ -22,6 +22,7 @@
 #include <stdio.h>
 
 #include "ImageUtils.hpp"
+#include "Parallel.hpp"
 
 bool
 ImageUtils::grayscalePng(Glib::RefPtr<Gdk::Pixbuf>& pixbuf, const Glib::ustring& filename)
@@ -41,18 +42,22 @@ ImageUtils::grayscalePng(Glib::RefPtr<Gdk::Pixbuf>& pixbuf, const Glib::ustring&
         //          << " height " << height
         //          << " bytePerPixel " << bytePerPixel
         //          << std::endl;
-        for (int32_t y = 0; y < height; ++y) {
-            //std::cout << "Convertring row " << y << std::endl;
-            // use add 2 to use green
-            auto rows = pixbuf->get_pixels() + 2 + (y * pixbuf->get_rowstride());
-            auto rowd = &graydata[y * width];
-            rowptr[y] = rowd;       // fill pointer for rows
-            for (int32_t x = 0; x < width; ++x) {
-                *rowd = *rows;
-                ++rowd;
-                rows += bytePerPixel;
+        auto pixels = pixbuf->get_pixels();
+        auto rowstride = pixbuf->get_rowstride();
+        psc::util::parallel_for(0u, static_cast<size_t>(height), PARALLEL_ROWS, [&] (size_t lo, size_t hi) {
+            for (size_t y = lo; y < hi; ++y) {
+                //std::cout << "Convertring row " << y << std::endl;
+                // use add 2 to use green
+                auto rows = pixels + 2 + (y * rowstride);
+                auto rowd = &graydata[y * width];
+                rowptr[y] = rowd;       // fill pointer for rows
+                for (int32_t x = 0; x < width; ++x) {
+                    *rowd = *rows;
+                    ++rowd;
+                    rows += bytePerPixel;
+                }
             }
-        }
+        });
         auto row_pointers = reinterpret_cast<png_bytepp>(rowptr);
         int interlace_type = PNG_INTERLACE_NONE; // ? PNG_INTERLACE_ADAM7
         int color_type = PNG_COLOR_TYPE_GRAY;
@@ -107,24 +112,28 @@ ImageUtils::blackandwhitePng(Glib::RefPtr<Gdk::Pixbuf>& pixbuf, const Glib::ustr
                   << " (src)bytePerPixel " << bytePerPixel
                   << " (dest)byteStride " << bytesStride
                   << std::endl;
-        for (int32_t y = 0; y < height; ++y) {
-            //std::cout << "Convertring row " << y << std::endl;
-            // use add 2 to use green
-            auto rows = pixbuf->get_pixels() + 2 + (y * pixbuf->get_rowstride());
-            auto rowd = &graydata[y * bytesStride];
-            rowptr[y] = rowd;       // fill pointer for rows
-            uint8_t byted = 0;
-            for (uint32_t x = 0; x < width; ++x) {
-                uint8_t mask = 0x80u >> (x & 0x7u);
-                byted |= *rows > 0x7fu ? mask : 0u;
-                if (mask == 0x01u || x == (width-1)) {
-                    *rowd = byted;
-                    ++rowd;
-                    byted = 0;
+        auto pixels = pixbuf->get_pixels();
+        auto rowstride = pixbuf->get_rowstride();
+        psc::util::parallel_for(0u, static_cast<size_t>(height), PARALLEL_ROWS, [&] (size_t lo, size_t hi) {
+            for (size_t y = lo; y < hi; ++y) {
+                //std::cout << "Convertring row " << y << std::endl;
+                // use add 2 to use green
+                auto rows = pixels + 2 + (y * rowstride);
+                auto rowd = &graydata[y * bytesStride];
+                rowptr[y] = rowd;       // fill pointer for rows
+                uint8_t byted = 0;
+                for (uint32_t x = 0; x < width; ++x) {
+                    uint8_t mask = 0x80u >> (x & 0x7u);
+                    byted |= *rows > 0x7fu ? mask : 0u;
+                    if (mask == 0x01u || x == (width-1)) {
+                        *rowd = byted;
+                        ++rowd;
+                        byted = 0;
+                    }
+                    rows += bytePerPixel;
                 }
-                rows += bytePerPixel;
             }
-        }
+        });
         auto row_pointers = reinterpret_cast<png_bytepp>(rowptr);
         int interlace_type = PNG_INTERLACE_NONE; // ? PNG_INTERLACE_ADAM7
         int color_type = PNG_COLOR_TYPE_GRAY;
@@ -156,6 +156,15 @@ ImageView<T,G>::ImageView(
         });
 }
 
+template<class T,typename G>
+ImageView<T,G>::~ImageView()
+{
+    // the list may outlive us, so make sure no query calls back
+    if (m_listStore) {
+        m_listStore->cancelQuery();
+    }
+}
+
 template<class T, typename G>
 void
 ImageView<T,G>::showView(int32_t front, std::vector<Glib::RefPtr<Gio::File>>& picts, ApplicationSupport& m_appSupport)
@@ -214,15 +223,11 @@ ImageView<T,G>::createDirMode()
     if (!f) {
         return nullptr;
     }
-    // collect all available content types
-    auto fmts = Gdk::Pixbuf::get_formats();
-    std::map<Glib::ustring, Gdk::PixbufFormat> mimeTypes;
-    for (auto fmt : fmts) {
-        for (auto mime : fmt.get_mime_types()) {
-            mimeTypes.insert(std::make_pair(mime, fmt));
-        }
-    }
-    auto en = f->enumerate_children("standard::*", Gio::FileQueryInfoFlags::FILE_QUERY_INFO_NONE);
+    const auto& formats = PixbufFormats::get();
+    const bool fast = m_scanMode == ScanMode::Fast;
+    // fast avoids the content sniffing (reading the file header) for each entry
+    auto en = f->enumerate_children(fast ? PixbufFormats::FAST_SCAN_ATTRIBUTES : PixbufFormats::SNIFF_SCAN_ATTRIBUTES
+                                    , Gio::FileQueryInfoFlags::FILE_QUERY_INFO_NONE);
     // prefere ustring as the sorting is more consistent
     //   using collate_key would be more effective ...
     //     the docs suggest using compare ...?
@@ -233,22 +238,66 @@ ImageView<T,G>::createDirMode()
             break;
         }
         if (fi->get_file_type() == Gio::FileType::FILE_TYPE_REGULAR) {  // enum should follow symlinks, so regular should catch linked files as well
-            auto cnt = fi->get_content_type();
-            //std::cout << "Found file " << fi->get_name() << " type " << cnt << std::endl;
-            if (mimeTypes.find(cnt) != mimeTypes.end()) {
-                auto fpath = Glib::canonicalize_filename(fi->get_name(), f->get_path());
-                auto file = Gio::File::create_for_path(fpath);
-                auto displayName = Glib::ustring(fi->get_display_name());
+            auto fpath = Glib::canonicalize_filename(fi->get_name(), f->get_path());
+            Glib::RefPtr<Gio::File> file;
+            bool readable;
+            if (fast) {
+                auto fastType = fi->get_attribute_string(G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
+                auto classified = formats.classify(fi->get_name(), fastType);
+                if (classified == Readable::Unknown) {     // only the ambiguous ones are read
+                    file = Gio::File::create_for_path(fpath);
+                    readable = formats.isReadable(file, ScanMode::Sniff);
+                }
+                else {
+                    readable = classified == Readable::Yes;
+                }
+            }
+            else {
+                readable = formats.isReadableMime(fi->get_content_type());
+            }
+            //std::cout << "Found file " << fi->get_name() << " readable " << readable << std::endl;
+            if (readable) {
+                if (!file) {
+                    file = Gio::File::create_for_path(fpath);
+                }
+                auto displayName = Glib::filename_display_name(fi->get_name());
                 map.insert(std::make_pair(displayName, file));
             }
         }
     }
     // map has sort names
     std::vector<Glib::RefPtr<Gio::File>> fs;
+    fs.reserve(map.size());
     for (auto entry : map) {
         fs.push_back(std::move(entry.second));
     }
-    return std::make_shared<PagingMode>(0, fs);
+    auto scanMode = m_scanMode;
+    auto accept = [scanMode] (const Glib::RefPtr<Gio::File>& file) {
+        return PixbufFormats::get().isReadable(file, scanMode);
+    };
+    auto dirMode = std::make_shared<DirMode>(f, fs, accept);
+    dirMode->signal_changed().connect(
+            sigc::mem_fun(*this, &ImageView<T,G>::on_mode_changed));
+    dirMode->signal_front_changed().connect(
+            sigc::mem_fun(*this, &ImageView<T,G>::on_front_changed));
+    return dirMode;
+}
+
+template<class T, typename G>
+void
+ImageView<T,G>::on_mode_changed()
+{
+    m_prevBtn->set_sensitive(m_mode->hasNavigation());
+    m_nextBtn->set_sensitive(m_mode->hasNavigation());
+}
+
+template<class T, typename G>
+void
+ImageView<T,G>::on_front_changed()
+{
+    if (m_mode->isComplete()) {
+        m_mode->show(this);     // the shown file is gone, show the neighbour
+    }
 }
 
 template<class T, typename G>
@@ -256,8 +305,21 @@ void
 ImageView<T,G>::setFile(const Glib::RefPtr<Gio::File>& file)
 {
     T::set_title(file->get_basename());
+    m_listStore->clear();
     m_content->setFile(file);
-    m_listStore->fillList(file);
+    m_listStore->queryAsync(file,
+        [this] (const Glib::RefPtr<Gio::File>& file, const Glib::RefPtr<Gio::FileInfo>& info) {
+            updateList([&] {
+                m_listStore->fillList(file, info);
+            });
+        });
+}
+
+template<class T, typename G>
+void
+ImageView<T,G>::updateList(const std::function<void()>& fill)
+{
+    ImageList::fillDetached(m_table, m_listStore, fill);
 }
 
 template<class T, typename G>
@@ -268,6 +330,7 @@ ImageView<T,G>::showFront()
         auto mode = createDirMode();
         if (mode) {
             m_mode = mode;
+            on_mode_changed();
         }
         else {
             m_prevBtn->set_sensitive(false);
@@ -283,6 +346,7 @@ void
 ImageView<T,G>::setDisplayImage(Glib::RefPtr<DisplayImage>& displayImage)
 {
     T::set_title("Edit");
+    m_listStore->cancelQuery();
     m_listStore->clear();
     m_content->setPixbuf(displayImage);
 }
@@ -292,8 +356,9 @@ void
 ImageView<T,G>::updateImageInfos(Glib::RefPtr<DisplayImage>& pixbuf)
 {
 	m_binView->setPixbuf(pixbuf);
-	m_listStore->fillList(pixbuf);
-	m_table->expand_all();
+    updateList([&] {
+        m_listStore->fillList(pixbuf);
+    });
 }
 
 template<class T, typename G>
@@ -408,11 +473,7 @@ ImageView<T,G>::build_popup(int x, int y)
         pMenuPopup->append(*save);
     }
     if (m_mode->hasNavigation()) {
-        auto last = Gtk::make_managed<Gtk::MenuItem>("_View", true);
-        pMenuPopup->append(*last);
-        auto subMenu = Gtk::make_managed<Gtk::Menu>();
-        last->set_submenu(*subMenu);
-        m_mode->buildMenu(subMenu, this, &ViewIntf::on_menu_n);
+        m_mode->buildMenu(pMenuPopup, this, &ViewIntf::on_menu_n);
     }
     auto select = Gtk::make_managed<Gtk::CheckMenuItem>("_Select", true);
     select->set_active(m_select);
@@ -547,18 +608,14 @@ template<class T, typename G>
 bool
 ImageView<T,G>::is_mime_gdk_readable(const Glib::ustring& mime)
 {
-	std::vector<Gdk::PixbufFormat> formats = Gdk::Pixbuf::get_formats();
-	bool supported = false;
-	for (Gdk::PixbufFormat format : formats) {	// only include images that are displayable (readable)
-		for (auto availMime : format.get_mime_types()) {
-			if (mime == availMime
-				&& !format.is_disabled()) {
-				supported = true;
-				break;
-			}
-		}
-	}
-	return supported;
+    return PixbufFormats::get().isReadableMime(mime);
+}
+
+template<class T, typename G>
+void
+ImageView<T,G>::setScanMode(ScanMode scanMode)
+{
+    m_scanMode = scanMode;
 }
 
 template<class T, typename G>
@@ -18,6 +18,13 @@
 
 #include <ctime>
 #include <iostream>
+#include <cstdlib>
+#include <array>
+#include <cstdio>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <functional>
 
 #include "genericimg_config.h"
 #include "Log.hpp"
@@ -27,15 +34,153 @@ namespace psc {
 namespace log {
 
 std::shared_ptr<Log> Log::m_log;
+std::atomic<Log*> Log::m_instance{nullptr};
+std::once_flag Log::m_createOnce;
 
 LogPlugin::LogPlugin(const char* prefix)
 : m_prefix{prefix}
 {
 }
 
+void
+LogPlugin::write(const LogRecord& record)
+{
+    log(record.level, record.msg, record.location);
+}
+
+void
+LogPlugin::writeBatch(const std::vector<LogRecord>& records)
+{
+    for (auto& record : records) {
+        write(record);
+    }
+}
+
+void
+LogPlugin::writeDeferred(LogRecord&& record)
+{
+    record.resolve();
+    write(record);
+}
+
+size_t
+LogLocationHash::operator()(const LogLocationKey& key) const
+{
+    return std::hash<const char*>()(key.file)
+         ^ (static_cast<size_t>(key.line) << 16u)
+         ^ key.column;
+}
+
+LogRateLimit::LogRateLimit()
+: m_burst{DEFAULT_BURST}
+, m_interval{0}
+, m_reportInterval{0}
+, m_nextReport{0}
+{
+    setLimit(DEFAULT_BURST, DEFAULT_RATE);
+}
+
+void
+LogRateLimit::setLimit(uint32_t burst, double perSecond, std::chrono::seconds reportInterval)
+{
+    // a year for each token is as good as no refill, and keeps the sums in range
+    constexpr double MAX_INTERVAL{365.0 * 24.0 * 60.0 * 60.0 * 1.0e9};
+    double interval = perSecond > 0.0
+                    ? std::min(1.0e9 / perSecond, MAX_INTERVAL)
+                    : MAX_INTERVAL;
+    m_interval.store(std::max(static_cast<int64_t>(interval), int64_t{1}), std::memory_order_relaxed);
+    auto reportNs = std::chrono::duration_cast<std::chrono::nanoseconds>(reportInterval).count();
+    m_reportInterval.store(reportNs, std::memory_order_relaxed);
+    m_nextReport.store(now() + reportNs, std::memory_order_relaxed);
+    m_burst.store(burst, std::memory_order_relaxed);
+}
+
+int64_t
+LogRateLimit::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool
+LogRateLimit::acquire(Level level, const std::source_location& location, uint32_t& suppressed)
+{
+    suppressed = 0u;
+    auto burst = m_burst.load(std::memory_order_relaxed);
+    if (burst == 0u
+     || level <= Level::Crit) {
+        return true;
+    }
+    auto bucket = m_buckets.compute_if_absent(LogLocationKey{location}, [&] (const LogLocationKey&) {
+        return std::make_shared<Bucket>(level, location);
+    });
+    auto interval = m_interval.load(std::memory_order_relaxed);
+    constexpr int64_t MAX_LIMIT{static_cast<int64_t>(1) << 62};
+    auto limit = interval > MAX_LIMIT / burst           // the time to fill all tokens
+               ? MAX_LIMIT
+               : static_cast<int64_t>(burst) * interval;
+    auto current = now();
+    auto full = bucket->full.load(std::memory_order_relaxed);
+    while (true) {
+        auto next = std::max(full, current) + interval;     // taking one token
+        if (next - current > limit) {
+            bucket->level.store(level, std::memory_order_relaxed);
+            bucket->suppressed.fetch_add(1u, std::memory_order_relaxed);
+            return false;
+        }
+        if (bucket->full.compare_exchange_weak(full, next, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    if (bucket->suppressed.load(std::memory_order_relaxed) > 0u) {  // avoid writing the shared line
+        suppressed = bucket->suppressed.exchange(0u, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+std::vector<LogRateLimit::Suppressed>
+LogRateLimit::takeSuppressed()
+{
+    std::vector<Suppressed> ret;
+    m_buckets.for_each([&ret] (const LogLocationKey&, const std::shared_ptr<Bucket>& bucket) {
+        if (bucket->suppressed.load(std::memory_order_relaxed) > 0u) {
+            auto count = bucket->suppressed.exchange(0u, std::memory_order_relaxed);
+            if (count > 0u) {
+                ret.emplace_back(Suppressed{bucket->level.load(std::memory_order_relaxed), bucket->location, count});
+            }
+        }
+    });
+    return ret;
+}
+
+std::vector<LogRateLimit::Suppressed>
+LogRateLimit::takeSuppressedDue()
+{
+    auto current = now();
+    auto nextReport = m_nextReport.load(std::memory_order_relaxed);
+    if (current < nextReport
+     || m_burst.load(std::memory_order_relaxed) == 0u) {
+        return {};
+    }
+    // only one of the threads passing meanwhile reports
+    if (!m_nextReport.compare_exchange_strong(nextReport
+                            , current + m_reportInterval.load(std::memory_order_relaxed)
+                            , std::memory_order_relaxed)) {
+        return {};
+    }
+    return takeSuppressed();
+}
+
 FilePlugin::FilePlugin(const char* prefix)
+: FilePlugin::FilePlugin(prefix, LOG_EXTENSION)
+{
+}
+
+FilePlugin::FilePlugin(const char* prefix, const char* extension)
 : LogPlugin::LogPlugin(prefix)
+, m_extension{extension}
 , m_sizeLimit{DEFAULT_SIZELIMITI}
+, m_generations{DEFAULT_GENERATIONS}
 {
 }
 
@@ -47,51 +192,181 @@ FilePlugin::~FilePlugin()
 void
 FilePlugin::close()
 {
+    std::lock_guard<std::mutex> lock{m_mutex};
     if (m_outstream) {
         m_outstream->close();
         m_outstream.clear();
     }
+    waitCompress();
 }
 
 
 void
 FilePlugin::create()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    open();
+}
+
+void
+FilePlugin::open()
 {
     auto logPath = Glib::canonicalize_filename("log", Glib::get_home_dir());
     Glib::RefPtr<Gio::File> fileLogPath = Gio::File::create_for_path(logPath);
     if (!fileLogPath->query_exists()) {
         fileLogPath->make_directory();
     }
-    auto name = m_prefix + ".log";
+    auto name = m_prefix + m_extension;
     auto fullPath = Glib::canonicalize_filename(name.c_str(), logPath);
     auto file = Gio::File::create_for_path(fullPath);
-    createLogFile(file);
+    openFile(file);
 }
 
 void
 FilePlugin::createLogFile(const Glib::RefPtr<Gio::File>& file)
 {
-	bool createStrm = true;
+    std::lock_guard<std::mutex> lock{m_mutex};
+    openFile(file);
+}
+
+void
+FilePlugin::openFile(const Glib::RefPtr<Gio::File>& file)
+{
+    m_file = file;
+    m_size = 0;
+    m_created = std::chrono::system_clock::now();
     if (file->query_exists()) {
-        auto fileAttr = file->query_info(G_FILE_ATTRIBUTE_STANDARD_SIZE);
-        if (fileAttr->get_size() > m_sizeLimit) {
-            file->remove(); // trunc existing alternative rolling
+        auto fileAttr = file->query_info(G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_CREATED);
+        m_size = fileAttr->get_size();
+        // the age continues from the previous run, if the filesystem tells the creation
+        if (fileAttr->has_attribute(G_FILE_ATTRIBUTE_TIME_CREATED)) {
+            m_created = std::chrono::system_clock::from_time_t(
+                    static_cast<std::time_t>(fileAttr->get_attribute_uint64(G_FILE_ATTRIBUTE_TIME_CREATED)));
         }
-        else {
-			createStrm = false;
+        if (isRotationDue()) {
+            rotateOrKeep();   // keeps the previous runs
         }
     }
-    if (createStrm) {
+    if (m_size == 0) {
         m_outstream = file->create_file(Gio::FileCreateFlags::FILE_CREATE_REPLACE_DESTINATION);
+        m_created = std::chrono::system_clock::now();
     }
 	else {
         m_outstream = file->append_to();
 	}
+    opened(m_size == 0);
+}
+
+void
+FilePlugin::opened(bool created)
+{
+}
+
+std::string
+FilePlugin::getGenerationPath(const std::string& path, uint32_t generation, bool compressed)
+{
+    auto generationPath = path + "." + std::to_string(generation);
+    if (compressed) {
+        generationPath += COMPRESSED_EXTENSION;
+    }
+    return generationPath;
+}
+
+bool
+FilePlugin::isRotationDue()
+{
+    return m_rotate
+        && (m_size > m_sizeLimit
+         || (m_maxAge.count() > 0
+          && std::chrono::system_clock::now() - m_created >= m_maxAge));
+}
+
+void
+FilePlugin::rotateOrKeep()
+{
+    try {
+        rotate();
+    }
+    catch (const Glib::Error& ex) {     // logging it here would be recursive
+        std::cerr << "Unable to rotate " << m_file->get_path() << " " << ex.what()
+                  << ", rotation disabled" << std::endl;
+        m_rotate = false;   // keep appending to the file we have
+        m_size = m_file->query_exists()
+                ? m_file->query_info(G_FILE_ATTRIBUTE_STANDARD_SIZE)->get_size()
+                : 0;
+    }
+}
+
+// shift name.log.N -> name.log.N+1 (dropping the oldest),
+//   and compress the former name.log.1 in the background
+void
+FilePlugin::rotate()
+{
+    if (m_outstream) {
+        m_outstream->close();
+        m_outstream.clear();
+    }
+    waitCompress();     // it works on a file we are going to move
+    m_size = 0;
+    if (m_generations == 0) {
+        m_file->remove();
+        return;
+    }
+    auto path = m_file->get_path();
+    for (uint32_t generation = m_generations; generation >= 1; --generation) {
+        bool compressed = generation >= 2;
+        auto file = Gio::File::create_for_path(getGenerationPath(path, generation, compressed));
+        if (!file->query_exists()) {
+            continue;
+        }
+        if (generation == m_generations) {
+            file->remove();
+        }
+        else {
+            file->move(Gio::File::create_for_path(getGenerationPath(path, generation + 1, compressed))
+                     , Gio::FileCopyFlags::FILE_COPY_OVERWRITE);
+        }
+    }
+    auto plainPath = getGenerationPath(path, 2, false);
+    bool toCompress = Gio::File::create_for_path(plainPath)->query_exists();
+    m_file->move(Gio::File::create_for_path(getGenerationPath(path, 1, false))
+               , Gio::FileCopyFlags::FILE_COPY_OVERWRITE);
+    if (toCompress) {
+        m_compressor = std::thread(&FilePlugin::compress, plainPath, getGenerationPath(path, 2, true));
+    }
+}
+
+void
+FilePlugin::waitCompress()
+{
+    if (m_compressor.joinable()) {
+        m_compressor.join();
+    }
+}
+
+void
+FilePlugin::compress(const std::string& path, const std::string& compressedPath)
+{
+    try {
+        auto file = Gio::File::create_for_path(path);
+        auto compressedFile = Gio::File::create_for_path(compressedPath);
+        auto compressor = Gio::ZlibCompressor::create(Gio::ZlibCompressorFormat::ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+        auto outstream = Gio::ConverterOutputStream::create(
+                compressedFile->replace(), compressor);
+        outstream->splice(file->read()
+                , Gio::OutputStreamSpliceFlags::OUTPUT_STREAM_SPLICE_CLOSE_SOURCE
+                | Gio::OutputStreamSpliceFlags::OUTPUT_STREAM_SPLICE_CLOSE_TARGET);
+        file->remove();
+    }
+    catch (const Glib::Error& ex) {     // logging it here would be recursive
+        std::cerr << "Unable to compress " << path << " " << ex.what() << std::endl;
+    }
 }
 
 void
 FilePlugin::setSizeLimit(goffset sizeLimit)
 {
+    std::lock_guard<std::mutex> lock{m_mutex};
     m_sizeLimit = sizeLimit;
 }
 
@@ -101,26 +376,148 @@ FilePlugin::getSizeLimit()
     return m_sizeLimit;
 }
 
+void
+FilePlugin::setMaxAge(std::chrono::seconds maxAge)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_maxAge = maxAge;
+}
+
+std::chrono::seconds
+FilePlugin::getMaxAge()
+{
+    return m_maxAge;
+}
+
+void
+FilePlugin::setGenerations(uint32_t generations)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_generations = generations;
+}
+
+uint32_t
+FilePlugin::getGenerations()
+{
+    return m_generations;
+}
+
 void
 FilePlugin::log(Level level
         , const Glib::ustring& msg
         , const std::source_location location)
 {
-    if (!m_outstream) {
-        create();
+    write(LogRecord{level, msg, location, std::chrono::system_clock::now(), Log::getThreadId()});
+}
+
+void
+FilePlugin::format(const LogRecord& record, std::string& out)
+{
+    if (record.level >= Level::Debug) {
+        out += "                                   ";
+        out += record.location.function_name();
+        out += '\n';
     }
-    Glib::ustring time = Log::getTimestamp();
-    if (level >= Level::Debug) {
-        Glib::ustring fn{location.function_name()};
-        m_outstream->write("                                   " + fn + "\n");
+    out += TimestampFormat::format(record.time);
+    std::array<char, 256> head;
+    // the thread is optional for the readers (was added later)
+    auto len = std::snprintf(head.data(), head.size(), " %s [%u] %20s:%3d "
+              , Log::getLevel(record.level)
+              , static_cast<unsigned int>(record.thread)
+              , record.location.file_name()
+              , static_cast<int>(record.location.line()));
+    if (len > 0) {
+        out.append(head.data(), std::min(static_cast<size_t>(len), head.size() - 1u));
     }
-    Glib::ustring out = Glib::ustring::sprintf("%s %s %20s:%3d %s\n"
-              , time
-              , Log::getLevel(level)
-              , location.file_name()
-              , location.line()
-              , msg) ;
-    m_outstream->write(out);
+    out += record.msg.raw();
+    out += '\n';
+}
+
+// each thread formats into its own buffer, so the lock is only needed for the output
+static thread_local std::string fileStaging;
+
+void
+FilePlugin::write(const LogRecord& record)
+{
+    fileStaging.clear();        // keeps the capacity
+    format(record, fileStaging);
+    output(fileStaging);
+}
+
+void
+FilePlugin::writeBatch(const std::vector<LogRecord>& records)
+{
+    fileStaging.clear();
+    for (auto& record : records) {
+        format(record, fileStaging);
+    }
+    if (!fileStaging.empty()) {
+        output(fileStaging);    // one call for all
+    }
+}
+
+bool
+FilePlugin::isText()
+{
+    return true;
+}
+
+void
+FilePlugin::writeText(std::string_view text)
+{
+    output(text);
+}
+
+void
+FilePlugin::output(std::string_view out)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    try {
+        prepare();
+        append(out);
+    }
+    catch (const Glib::Error& ex) {
+        failed(ex);
+    }
+}
+
+void
+FilePlugin::failed(const Glib::Error& ex)
+{
+    if (!m_failed) {        // report it once, not for each line
+        std::cerr << "Unable to write log " << (m_file ? m_file->get_path() : m_prefix.raw())
+                  << " " << ex.what() << std::endl;
+        m_failed = true;
+    }
+    if (m_outstream) {      // try again with the next output
+        m_outstream.clear();
+    }
+}
+
+void
+FilePlugin::prepare()
+{
+    if (m_outstream
+     && isRotationDue()) {
+        rotateOrKeep();
+    }
+    if (!m_outstream) {
+        if (m_file) {
+            openFile(m_file);
+        }
+        else {
+            open();
+        }
+    }
+}
+
+void
+FilePlugin::append(std::string_view out)
+{
+    gsize written;
+    m_outstream->write_all(out.data(), out.size(), written);
+    m_size += static_cast<goffset>(out.size());
+    m_failed = false;       // a new failure gets reported again
 }
 
 static std::shared_ptr<LogPlugin>
@@ -140,24 +537,30 @@ defaultLogType(const char* prefix)
 Log::Log(const std::shared_ptr<LogPlugin>& plugin)
 : m_level{Level::Info}
 , m_plugin{plugin}
+, m_pluginLevel{plugin && plugin->getLevel().has_value()}
 {
+    if (m_pluginLevel) {
+        m_level.store(Level::Debug, std::memory_order_relaxed);    // the plugin decides, setLevel may restrict
+    }
 }
 
 Log::~Log()
 {
+    Log* self{this};    // logAdd shall not use us anymore
+    m_instance.compare_exchange_strong(self, nullptr);
     close();
 }
 
 Level
 Log::getLevel()
 {
-    return m_level;
+    return m_level.load(std::memory_order_relaxed);
 }
 
 void
 Log::setLevel(Level level)
 {
-    m_level = level;
+    m_level.store(level, std::memory_order_relaxed);
 }
 
 std::shared_ptr<LogPlugin>
@@ -194,12 +597,43 @@ Log::debug(const Glib::ustring& msg
     log(Level::Debug, msg, location);
 }
 
+void
+Log::setRateLimit(uint32_t burst, double perSecond, std::chrono::seconds reportInterval)
+{
+    m_rateLimit.setLimit(burst, perSecond, reportInterval);
+}
+
+bool
+Log::isPassing(Level level, const std::source_location& location)
+{
+    if (!isLoggable(level)) {
+        return false;
+    }
+    uint32_t suppressed;
+    if (!m_rateLimit.acquire(level, location, suppressed)) {
+        return false;
+    }
+    if (suppressed > 0u) {
+        reportSuppressed(level, suppressed, location);
+    }
+    for (auto& other : m_rateLimit.takeSuppressedDue()) {    // the sites that went quiet
+        reportSuppressed(other.level, other.count, other.location);
+    }
+    return true;
+}
+
+void
+Log::reportSuppressed(Level level, uint32_t count, const std::source_location& location)
+{
+    m_plugin->log(level, psc::fmt::format("{} similar messages suppressed", count), location);
+}
+
 void
 Log::log(Level level
         , const Glib::ustring& msg
         , const std::source_location location)
 {
-    if (m_plugin && isLoggable(level)) {
+    if (m_plugin && isPassing(level, location)) {
         m_plugin->log(level, msg, location);
     }
 }
@@ -209,7 +643,7 @@ Log::log(Level level
         , std::function< Glib::ustring(void) >&& lambda
         , const std::source_location location)
 {
-    if (m_plugin && isLoggable(level)) {
+    if (m_plugin && isPassing(level, location)) {
         m_plugin->log(level, lambda(), location);
     }
 }
@@ -238,9 +672,10 @@ Log::logAdd(Level level
         , const Glib::ustring& msg
         , const std::source_location location)
 {
-    if (m_log) {
-        if (m_log->isLoggable(level)) {
-            m_log->log(level, msg, location);
+    auto log = m_instance.load(std::memory_order_acquire);
+    if (log) {
+        if (log->isLoggable(level)) {
+            log->log(level, msg, location);
         }
     }
     else {
@@ -255,11 +690,12 @@ Log::logAdd(Level level
         , std::function< Glib::ustring(void) >&& lambda
 	    , const std::source_location location)
 {
-	if (m_log) {
-        if (m_log->isLoggable(level)) {
-            m_log->log(level, lambda(), location);
-    	}
-	}
+    auto log = m_instance.load(std::memory_order_acquire);
+    if (log) {
+        if (log->isLoggable(level)) {
+            log->log(level, std::move(lambda), location);  // evaluated if not suppressed
+        }
+    }
     else {
         std::cout << getTimestamp()
                   << " " << getLevel(level)
@@ -271,21 +707,43 @@ Log::logAdd(Level level
 Glib::ustring
 Log::getTimestamp()
 {
-    auto dateTime = Glib::DateTime::create_now_local();
-    Glib::ustring time;
-    if (dateTime) {
-        time = dateTime.format("%F %T.%f");
-        time = time.substr(0, time.length() - 3);   // cut us
+    return getTimestamp(std::chrono::system_clock::now());
+}
+
+Glib::ustring
+Log::getTimestamp(std::chrono::system_clock::time_point tp)
+{
+    auto time = TimestampFormat::format(tp);
+    return Glib::ustring(time.data(), time.size());
+}
+
+std::string_view
+TimestampFormat::format(std::chrono::system_clock::time_point time)
+{
+    struct Cache
+    {
+        int64_t second{std::numeric_limits<int64_t>::min()};
+        std::array<char, LENGTH + 1u> text{};
+    };
+    thread_local Cache cache;
+    auto secs = std::chrono::floor<std::chrono::seconds>(time);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(time - secs).count();
+    int64_t second = secs.time_since_epoch().count();
+    if (second != cache.second) {
+        // localtime_r keeps the loaded zone, unlike Glib::DateTime that looks it up each time
+        time_t rawtime = static_cast<time_t>(second);
+        struct tm timeinfo;
+        if (localtime_r(&rawtime, &timeinfo) == nullptr
+         || std::strftime(cache.text.data(), cache.text.size(), "%F %T", &timeinfo) != LENGTH - 4u) {
+            return std::string_view();
+        }
+        cache.text[LENGTH - 4u] = '.';
+        cache.second = second;
     }
-//  else {
-//       time_t rawtime;
-//       std::time(&rawtime);
-//       struct tm* timeinfo = std::localtime(&rawtime);
-//       char buffer[80];
-//       std::strftime(buffer, sizeof(buffer), "%F %T", timeinfo);
-//       time = buffer;
-//   }
-    return time;
+    cache.text[LENGTH - 3u] = static_cast<char>('0' + millis / 100);
+    cache.text[LENGTH - 2u] = static_cast<char>('0' + millis / 10 % 10);
+    cache.text[LENGTH - 1u] = static_cast<char>('0' + millis % 10);
+    return std::string_view(cache.text.data(), LENGTH);
 }
 
 const char*
@@ -363,42 +821,91 @@ Log::getLevel(const Glib::ustring& level)
 }
 
 std::shared_ptr<Log>
-Log::create(const char* prefix, Type type)
+Log::create(const char* prefix, Type type, WriteMode writeMode)
 {
-    if (!m_log) {
-        std::shared_ptr<LogPlugin> plugin;
-        switch (type) {
-        case Type::Default:
-            plugin = defaultLogType(prefix);
-            break;
-        case Type::File:
-            plugin = std::make_shared<FilePlugin>(prefix);
-            break;
-        case Type::Console:
-            plugin = std::make_shared<ConsolePlugin>(prefix);
-            break;
-        case Type::None:
-            plugin.reset();
-            break;
-        default:
-            std::cerr << "No logging set!" << std::endl;
-            break;
-        }
-        m_log = std::make_shared<Log>(plugin);
-    }
+    std::call_once(m_createOnce, [&] {
+        install(createPlugin(prefix, type), writeMode);
+    });
     return m_log;
 }
 
+std::shared_ptr<Log>
+Log::create(const std::shared_ptr<LogPlugin>& plugin, WriteMode writeMode)
+{
+    std::call_once(m_createOnce, [&] {
+        install(plugin, writeMode);
+    });
+    return m_log;
+}
+
+void
+Log::install(std::shared_ptr<LogPlugin> plugin, WriteMode writeMode)
+{
+    if (plugin && writeMode == WriteMode::Async) {
+        plugin = std::make_shared<AsyncPlugin>(plugin);
+    }
+    // leaked intentionally (the deleter does nothing), so the global log stays usable
+    //   during the static destruction, e.g. by threads still running or destructors that log
+    m_log = std::shared_ptr<Log>(new Log(plugin), [] (Log*) {
+    });
+    m_instance.store(m_log.get(), std::memory_order_release);
+    // but written completely at exit
+    std::atexit([] {
+        m_log->close();
+    });
+}
+
+std::shared_ptr<LogPlugin>
+Log::createPlugin(const char* prefix, Type type)
+{
+    std::shared_ptr<LogPlugin> plugin;
+    switch (type) {
+    case Type::Default:
+        plugin = defaultLogType(prefix);
+        break;
+    case Type::File:
+        plugin = std::make_shared<FilePlugin>(prefix);
+        break;
+    case Type::Console:
+        plugin = std::make_shared<ConsolePlugin>(prefix);
+        break;
+    case Type::Binary:
+        plugin = std::make_shared<BinaryPlugin>(prefix);
+        break;
+    case Type::None:
+        plugin.reset();
+        break;
+    default:
+        std::cerr << "No logging set!" << std::endl;
+        break;
+    }
+    return plugin;
+}
+
 std::shared_ptr<Log>
 Log::getGlobalLog()
 {
+    if (m_instance.load(std::memory_order_acquire) == nullptr) {
+        return std::shared_ptr<Log>();  // not yet (completely) created
+    }
     return m_log;
 }
 
+uint32_t
+Log::getThreadId()
+{
+    static std::atomic<uint32_t> nextId{1u};
+    thread_local uint32_t threadId{nextId.fetch_add(1u, std::memory_order_relaxed)};
+    return threadId;
+}
+
 void
 Log::close()
 {
     if (m_plugin) {
+        for (auto& suppressed : m_rateLimit.takeSuppressed()) {
+            reportSuppressed(suppressed.level, suppressed.count, suppressed.location);
+        }
         m_plugin->close();
     }
 }
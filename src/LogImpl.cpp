@@ -17,6 +17,12 @@
  */
 
 #include <iostream>
+#include <string_view>
+#include <algorithm>
+#include <charconv>
+#include <utility>
+#include <cstring>
+#include <unistd.h>
 
 #include "LogImpl.hpp"
 #include "genericimg_config.h"
@@ -43,15 +49,542 @@ ConsolePlugin::log(Level level
         , const Glib::ustring& msg
         , const std::source_location location)
 {
-    Glib::ustring time = Log::getTimestamp();
-    if (level >= Level::Debug) {
-        std::cout << location.function_name() << '\n';
+    write(LogRecord{level, msg, location, std::chrono::system_clock::now(), Log::getThreadId()});
+}
+
+void
+ConsolePlugin::write(const LogRecord& record)
+{
+    auto time = TimestampFormat::format(record.time);
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (record.level >= Level::Debug) {
+        std::cout << record.location.function_name() << '\n';
     }
     std::cout << time
-              << " " << Log::getLevel(level)
-              << " " << location.file_name()
-              << ":" << location.line()
-              << " " << msg << std::endl;
+              << " " << Log::getLevel(record.level)
+              << " [" << record.thread << "]"
+              << " " << record.location.file_name()
+              << ":" << record.location.line()
+              << " " << record.msg << std::endl;
+}
+
+BinaryPlugin::BinaryPlugin(const char* prefix)
+: FilePlugin::FilePlugin(prefix, EXTENSION)
+{
+}
+
+void
+BinaryPlugin::opened(bool created)
+{
+    if (created) {
+        append(std::string_view(MAGIC.data(), MAGIC.size()));
+    }
+    m_described.assign(m_described.size(), false);  // the new file needs the descriptions
+}
+
+bool
+BinaryPlugin::isText()
+{
+    return false;
+}
+
+uint32_t
+BinaryPlugin::intern(const std::source_location& location, std::string& out)
+{
+    LogLocationKey key{location};
+    auto entry = m_locations.find(key);
+    uint32_t id;
+    if (entry == m_locations.end()) {
+        id = static_cast<uint32_t>(m_locations.size());
+        m_locations.emplace(key, id);
+        m_described.push_back(false);
+    }
+    else {
+        id = entry->second;
+    }
+    if (!m_described[id]) {
+        std::string_view file{location.file_name()};
+        std::string_view function{location.function_name()};
+        uint32_t line = location.line();
+        BinaryRecordHeader header{};
+        header.location = id;
+        header.length = static_cast<uint32_t>(sizeof(line) + file.length() + 1u + function.length());
+        header.type = BinaryRecordType::Location;
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.append(reinterpret_cast<const char*>(&line), sizeof(line));
+        out.append(file);
+        out += '\0';
+        out.append(function);
+        m_described[id] = true;
+    }
+    return id;
+}
+
+void
+BinaryPlugin::encode(const LogRecord& record, std::string& out)
+{
+    BinaryRecordHeader header{};
+    header.location = intern(record.location, out);
+    header.time = std::chrono::duration_cast<std::chrono::microseconds>(record.time.time_since_epoch()).count();
+    header.thread = record.thread;
+    std::string_view msg{record.msg.raw()};
+    if (msg.length() > MAX_LENGTH) {
+        auto length = static_cast<size_t>(MAX_LENGTH);
+        while (length > 0 && (msg[length] & 0xc0) == 0x80) {    // keep whole utf-8 chars
+            --length;
+        }
+        msg = msg.substr(0, length);
+    }
+    header.length = static_cast<uint32_t>(msg.length());
+    header.type = BinaryRecordType::Entry;
+    header.level = static_cast<uint8_t>(record.level);
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.append(msg);
+}
+
+static thread_local std::string binaryStaging;
+
+// the encoding is just copying, so it is done with the lock held
+void
+BinaryPlugin::write(const LogRecord& record)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    try {
+        prepare();
+        binaryStaging.clear();
+        encode(record, binaryStaging);
+        append(binaryStaging);
+    }
+    catch (const Glib::Error& ex) {
+        failed(ex);
+    }
+}
+
+void
+BinaryPlugin::writeBatch(const std::vector<LogRecord>& records)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    try {
+        prepare();
+        binaryStaging.clear();
+        for (auto& record : records) {
+            encode(record, binaryStaging);
+        }
+        if (!binaryStaging.empty()) {
+            append(binaryStaging);
+        }
+    }
+    catch (const Glib::Error& ex) {
+        failed(ex);
+    }
+}
+
+RingPlugin::RingPlugin(size_t capacity)
+: LogPlugin::LogPlugin("")
+, m_lines(std::max(capacity, size_t{1u}))
+{
+}
+
+void
+RingPlugin::log(Level level
+        , const Glib::ustring& msg
+        , const std::source_location location)
+{
+    write(LogRecord{level, msg, location, std::chrono::system_clock::now(), Log::getThreadId()});
+}
+
+static thread_local std::string ringStaging;
+
+void
+RingPlugin::write(const LogRecord& record)
+{
+    ringStaging.clear();
+    FilePlugin::format(record, ringStaging);
+    writeText(ringStaging);
+}
+
+bool
+RingPlugin::isText()
+{
+    return true;
+}
+
+void
+RingPlugin::writeText(std::string_view text)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    while (!text.empty()) {
+        auto end = text.find('\n');
+        auto line = text.substr(0u, end);
+        m_lines[m_next].assign(line);
+        m_next = (m_next + 1u) % m_lines.size();
+        m_count = std::min(m_count + 1u, m_lines.size());
+        if (end == text.npos) {
+            break;
+        }
+        text.remove_prefix(end + 1u);
+    }
+}
+
+std::vector<std::string>
+RingPlugin::getLines()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    std::vector<std::string> lines;
+    lines.reserve(m_count);
+    auto start = (m_next + m_lines.size() - m_count) % m_lines.size();
+    for (size_t i = 0; i < m_count; ++i) {
+        lines.emplace_back(m_lines[(start + i) % m_lines.size()]);
+    }
+    return lines;
+}
+
+void
+RingPlugin::clear()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_next = 0u;
+    m_count = 0u;
+}
+
+LogSink::LogSink(const std::shared_ptr<LogPlugin>& plugin, Level level, const Filter& filter)
+: m_plugin{plugin}
+, m_level{level}
+, m_filter{filter}
+{
+}
+
+bool
+LogSink::accepts(const LogRecord& record)
+{
+    return record.level <= m_level.load(std::memory_order_relaxed)
+        && (!m_filter || m_filter(record));
+}
+
+Level
+LogSink::getLevel()
+{
+    return m_level.load(std::memory_order_relaxed);
+}
+
+void
+LogSink::setLevel(Level level)
+{
+    m_level.store(level, std::memory_order_relaxed);
+}
+
+const std::shared_ptr<LogPlugin>&
+LogSink::getPlugin()
+{
+    return m_plugin;
+}
+
+FanoutPlugin::FanoutPlugin()
+: LogPlugin::LogPlugin("")
+, m_sinks{std::make_shared<const Sinks>()}
+{
+}
+
+pLogSink
+FanoutPlugin::addSink(const std::shared_ptr<LogPlugin>& plugin, Level level, const LogSink::Filter& filter)
+{
+    auto sink = std::make_shared<LogSink>(plugin, level, filter);
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto sinks = std::make_shared<Sinks>(*m_sinks.load());
+    sinks->push_back(sink);
+    updateLevel(*sinks);
+    m_sinks.store(std::move(sinks));
+    return sink;
+}
+
+void
+FanoutPlugin::removeSink(const pLogSink& sink)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto sinks = std::make_shared<Sinks>(*m_sinks.load());
+    std::erase(*sinks, sink);
+    updateLevel(*sinks);
+    m_sinks.store(std::move(sinks));
+}
+
+void
+FanoutPlugin::setSinkLevel(const pLogSink& sink, Level level)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    sink->setLevel(level);
+    updateLevel(*m_sinks.load());
+}
+
+void
+FanoutPlugin::updateLevel(const Sinks& sinks)
+{
+    auto level = Level::Severe;
+    for (auto& sink : sinks) {
+        level = std::max(level, sink->getLevel());
+    }
+    m_level.store(level, std::memory_order_relaxed);
+}
+
+std::optional<Level>
+FanoutPlugin::getLevel()
+{
+    return m_level.load(std::memory_order_relaxed);
+}
+
+void
+FanoutPlugin::log(Level level
+        , const Glib::ustring& msg
+        , const std::source_location location)
+{
+    write(LogRecord{level, msg, location, std::chrono::system_clock::now(), Log::getThreadId()});
+}
+
+// the lines for the text sinks, formatted on demand
+static thread_local std::string fanoutStaging;
+static thread_local std::vector<size_t> fanoutOffsets;
+static thread_local std::vector<char> fanoutAccepted;
+
+// the text sinks are served first, so the staging is complete
+//   before other sinks are called (these may use it as well e.g. a nested fanout)
+void
+FanoutPlugin::write(const LogRecord& record)
+{
+    auto sinks = m_sinks.load();
+    bool formatted{false};
+    for (bool text : {true, false}) {
+        for (auto& sink : *sinks) {
+            auto& plugin = sink->getPlugin();
+            if (plugin->isText() != text
+             || !sink->accepts(record)) {
+                continue;
+            }
+            if (text) {
+                if (!formatted) {
+                    fanoutStaging.clear();
+                    FilePlugin::format(record, fanoutStaging);
+                    formatted = true;
+                }
+                plugin->writeText(fanoutStaging);
+            }
+            else {
+                plugin->write(record);
+            }
+        }
+    }
+}
+
+// each text sink gets the accepted lines with as few calls as possible
+void
+FanoutPlugin::writeBatch(const std::vector<LogRecord>& records)
+{
+    auto sinks = m_sinks.load();
+    bool formatted{false};
+    for (bool text : {true, false}) {
+        for (auto& sink : *sinks) {
+            auto& plugin = sink->getPlugin();
+            if (plugin->isText() != text) {
+                continue;
+            }
+            fanoutAccepted.clear();
+            bool all{true};
+            for (auto& record : records) {
+                bool accepted = sink->accepts(record);
+                fanoutAccepted.push_back(accepted ? 1 : 0);
+                all = all && accepted;
+            }
+            if (text) {
+                if (!formatted) {
+                    fanoutStaging.clear();
+                    fanoutOffsets.clear();
+                    for (auto& record : records) {
+                        fanoutOffsets.push_back(fanoutStaging.length());
+                        FilePlugin::format(record, fanoutStaging);
+                    }
+                    fanoutOffsets.push_back(fanoutStaging.length());
+                    formatted = true;
+                }
+                std::string_view staging{fanoutStaging};
+                size_t start{0u};
+                for (size_t i = 0; i <= records.size(); ++i) {
+                    if (i == records.size()
+                     || !fanoutAccepted[i]) {   // write the accepted before
+                        if (i > start) {
+                            plugin->writeText(staging.substr(fanoutOffsets[start], fanoutOffsets[i] - fanoutOffsets[start]));
+                        }
+                        start = i + 1u;
+                    }
+                }
+            }
+            else if (all) {
+                plugin->writeBatch(records);
+            }
+            else {
+                for (size_t i = 0; i < records.size(); ++i) {
+                    if (fanoutAccepted[i]) {
+                        plugin->write(records[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void
+FanoutPlugin::writeDeferred(LogRecord&& record)
+{
+    record.resolve();   // once for all
+    write(record);
+}
+
+void
+FanoutPlugin::flush()
+{
+    auto sinks = m_sinks.load();
+    for (auto& sink : *sinks) {
+        sink->getPlugin()->flush();
+    }
+}
+
+void
+FanoutPlugin::close()
+{
+    auto sinks = m_sinks.load();
+    for (auto& sink : *sinks) {
+        sink->getPlugin()->close();
+    }
+}
+
+AsyncPlugin::AsyncPlugin(const std::shared_ptr<LogPlugin>& target)
+: LogPlugin::LogPlugin("")
+, m_target{target}
+, m_writer{&AsyncPlugin::run, this}
+{
+}
+
+AsyncPlugin::~AsyncPlugin()
+{
+    close();
+}
+
+std::shared_ptr<LogPlugin>
+AsyncPlugin::getTarget()
+{
+    return m_target;
+}
+
+void
+AsyncPlugin::log(Level level
+        , const Glib::ustring& msg
+        , const std::source_location location)
+{
+    write(LogRecord{level, msg, location, std::chrono::system_clock::now(), Log::getThreadId()});
+}
+
+void
+AsyncPlugin::write(const LogRecord& record)
+{
+    writeDeferred(LogRecord(record));
+}
+
+void
+AsyncPlugin::writeDeferred(LogRecord&& record)
+{
+    // announce us before checking, so close either sees us or we see it closing
+    m_producers.fetch_add(1u, std::memory_order_seq_cst);
+    if (m_closing.load(std::memory_order_seq_cst)) {
+        if (m_producers.fetch_sub(1u, std::memory_order_release) == 1u) {
+            m_producers.notify_all();
+        }
+        m_target->writeDeferred(std::move(record));     // closed, keep it anyway
+        return;
+    }
+    auto level = record.level;
+    uint64_t ticket = m_queue.push_back(std::move(record)) + 1u;
+    m_state.fetch_add(1u, std::memory_order_release);
+    m_state.notify_one();
+    if (m_producers.fetch_sub(1u, std::memory_order_release) == 1u) {
+        m_producers.notify_all();
+    }
+    if (level <= Level::Crit) {     // we may not get another chance
+        waitWritten(ticket);
+    }
+}
+
+void
+AsyncPlugin::waitWritten(uint64_t ticket)
+{
+    auto written = m_written.load(std::memory_order_acquire);
+    while (written < ticket) {
+        m_written.wait(written, std::memory_order_acquire);
+        written = m_written.load(std::memory_order_acquire);
+    }
+}
+
+std::optional<Level>
+AsyncPlugin::getLevel()
+{
+    return m_target->getLevel();
+}
+
+void
+AsyncPlugin::flush()
+{
+    waitWritten(m_queue.getEnqueued());
+}
+
+void
+AsyncPlugin::close()
+{
+    std::lock_guard<std::mutex> lock{m_closeMutex};
+    if (!m_writer.joinable()) {
+        return;
+    }
+    m_closing.store(true, std::memory_order_seq_cst);
+    // the producers that got in will complete their push,
+    //   the writer keeps running, so a push into a full queue can finish
+    auto producers = m_producers.load(std::memory_order_seq_cst);
+    while (producers > 0u) {
+        m_producers.wait(producers, std::memory_order_acquire);
+        producers = m_producers.load(std::memory_order_acquire);
+    }
+    // now every claimed slot is published, and no one will claim another
+    m_state.fetch_or(CLOSED, std::memory_order_release);
+    m_state.notify_one();
+    m_writer.join();
+    m_target->close();
+}
+
+void
+AsyncPlugin::run()
+{
+    std::vector<LogRecord> batch;
+    while (true) {
+        auto state = m_state.load(std::memory_order_acquire);
+        m_queue.pop_front(batch);
+        if (!batch.empty()) {
+            try {
+                for (auto& record : batch) {
+                    record.resolve();
+                }
+                m_target->writeBatch(batch);
+                m_target->flush();
+            }
+            catch (const Glib::Error& exc) {     // keep going, there is nobody to tell
+                std::cerr << "AsyncPlugin::run " << exc.what() << std::endl;
+            }
+            catch (const std::exception& exc) {
+                std::cerr << "AsyncPlugin::run " << exc.what() << std::endl;
+            }
+            m_written.fetch_add(batch.size(), std::memory_order_release);
+            m_written.notify_all();
+            batch.clear();
+            continue;   // look again, before waiting
+        }
+        if (state & CLOSED) {   // all published were seen, and drained
+            break;
+        }
+        m_state.wait(state, std::memory_order_acquire);     // returns if anything was added or closed
+    }
 }
 
 
@@ -64,23 +597,54 @@ SysdPlugin::SysdPlugin(const char* prefix)
 void
 SysdPlugin::log(Level level, const Glib::ustring& msg, const std::source_location location)
 {
-    std::array<Glib::ustring, 5> ustr{
-          Glib::ustring::sprintf("MESSAGE=%s", msg)
-        , Glib::ustring::sprintf("CODE_FILE=%s", location.file_name())
-        , Glib::ustring::sprintf("CODE_LINE=%d", location.line())
-        , Glib::ustring::sprintf("CODE_FUNC=%s", location.function_name())
-        , Glib::ustring::sprintf("PRIORITY=%d", static_cast<typename std::underlying_type<Level>::type>(level))
-    };
-    struct iovec iov[ustr.size()];
-    for (uint32_t i = 0; i < ustr.size(); ++i) {
-        // need const-cast as struct is defined as volatile
-        iov[i].iov_base = const_cast<void*>(static_cast<const void*>(ustr[i].c_str()));
-        iov[i].iov_len = ustr[i].length();
-    }
-    uint32_t iovcnt = ustr.size();
-    int ret = sd_journal_sendv(iov, iovcnt);    // output as is
-    if (ret != 0) {
-        std::cout << "error send systemd log " << strerror(ret)
+    send(level, msg.raw(), location);
+}
+
+void
+SysdPlugin::write(const LogRecord& record)
+{
+    send(record.level, record.msg.raw(), record.location);
+}
+
+// the fields are collected in one buffer for each thread,
+//   so once it has grown no allocation is required
+static thread_local std::string journalStaging;
+
+void
+SysdPlugin::send(Level level, std::string_view msg, const std::source_location& location)
+{
+    thread_local pid_t tid{gettid()};
+    std::array<char, 16> line;
+    auto lineEnd = std::to_chars(line.data(), line.data() + line.size(), location.line()).ptr;
+    std::array<char, 16> priority;
+    auto priorityEnd = std::to_chars(priority.data(), priority.data() + priority.size()
+                                   , static_cast<typename std::underlying_type<Level>::type>(level)).ptr;
+    std::array<char, 16> thread;
+    auto threadEnd = std::to_chars(thread.data(), thread.data() + thread.size(), tid).ptr;
+    const std::array<std::pair<std::string_view, std::string_view>, FIELDS> fields{{
+          {"MESSAGE=", msg}
+        , {"CODE_FILE=", location.file_name()}
+        , {"CODE_LINE=", std::string_view(line.data(), lineEnd)}
+        , {"CODE_FUNC=", location.function_name()}
+        , {"PRIORITY=", std::string_view(priority.data(), priorityEnd)}
+        , {"TID=", std::string_view(thread.data(), threadEnd)}
+    }};
+    journalStaging.clear();
+    std::array<size_t, FIELDS + 1u> offset;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        offset[i] = journalStaging.length();
+        journalStaging.append(fields[i].first);
+        journalStaging.append(fields[i].second);
+    }
+    offset[FIELDS] = journalStaging.length();
+    std::array<struct iovec, FIELDS> iov;   // the buffer is complete, so the pointers stay valid
+    for (size_t i = 0; i < FIELDS; ++i) {
+        iov[i].iov_base = journalStaging.data() + offset[i];
+        iov[i].iov_len = offset[i + 1u] - offset[i];
+    }
+    int ret = sd_journal_sendv(iov.data(), static_cast<int>(iov.size()));    // output as is
+    if (ret < 0) {
+        std::cout << "error send systemd log " << strerror(-ret)
                   << " msg " << msg << std::endl;
     }
     //sd_journal_send is ... different
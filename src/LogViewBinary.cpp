@@ -0,0 +1,203 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <limits>
+#include <algorithm>
+
+#include "LogViewBinary.hpp"
+
+
+namespace psc {
+namespace log {
+
+
+LogViewBinary::LogViewBinary()
+: LogViewFile::LogViewFile()
+{
+}
+
+LogViewIterator
+LogViewBinary::begin()
+{
+    auto logViewBinary = shared_from_this();
+    auto logViewFileIterator = std::make_shared<LogViewBinaryIterator>(m_query, logViewBinary);
+    logViewFileIterator->inc();
+    return LogViewIterator(logViewFileIterator);
+}
+
+LogViewIterator
+LogViewBinary::end()
+{
+    auto logViewFileIterator = std::make_shared<LogViewBinaryIterator>();
+    return LogViewIterator(logViewFileIterator);
+}
+
+pLogViewBinary
+LogViewBinary::create()
+{
+    return std::make_shared<LogViewBinary>();
+}
+
+bool
+LogViewBinary::isListed(const std::filesystem::path& path)
+{
+    return isLogFile(path, BinaryPlugin::EXTENSION);
+}
+
+bool
+LogViewBinary::readMagic(std::istream& stream)
+{
+    std::array<char, BinaryPlugin::MAGIC.size()> magic;
+    stream.read(magic.data(), magic.size());
+    return magic == BinaryPlugin::MAGIC;
+}
+
+void
+LogViewBinary::readHeader(std::istream& stream, BinaryRecordHeader& header)
+{
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (header.length > BinaryPlugin::MAX_LENGTH) {     // damaged, the following can't be trusted
+        throw std::ios_base::failure("LogViewBinary record length " + std::to_string(header.length));
+    }
+}
+
+void
+LogViewBinary::readLocation(std::istream& stream, const BinaryRecordHeader& header, std::vector<std::string>& locations)
+{
+    uint32_t line{};
+    if (header.length < sizeof(line)) {
+        stream.ignore(header.length);
+        return;
+    }
+    stream.read(reinterpret_cast<char*>(&line), sizeof(line));
+    std::string names(header.length - sizeof(line), '\0');
+    stream.read(names.data(), names.length());
+    auto sep = names.find('\0');
+    std::string location;
+    if (sep != names.npos) {
+        location = names.substr(0, sep) + ":" + std::to_string(line) + " " + names.substr(sep + 1);
+    }
+    else {
+        location = names + ":" + std::to_string(line);
+    }
+    if (header.location >= locations.size()) {
+        locations.resize(header.location + 1u);
+    }
+    locations[header.location] = std::move(location);  // a later description (e.g. appended by a new run) replaces
+}
+
+// as the local day is required for each entry,
+//   remember the range of the last one to avoid most time zone conversions
+std::map<LogDays, uint64_t>
+LogViewBinary::groupDays(const std::filesystem::path& path)
+{
+    std::map<LogDays, uint64_t> map;
+    try {
+        auto stream = openStream(path);
+        stream->exceptions(std::ios::failbit | std::ios::badbit);
+        if (!readMagic(*stream)) {
+            return map;     // not compatible
+        }
+        uint64_t pos = BinaryPlugin::MAGIC.size();
+        int64_t dayStart{std::numeric_limits<int64_t>::max()};
+        int64_t dayEnd{std::numeric_limits<int64_t>::min()};
+        BinaryRecordHeader header;
+        while (stream->peek() != std::char_traits<char>::eof()) {
+            readHeader(*stream, header);
+            if (header.type == BinaryRecordType::Entry
+             && (header.time < dayStart || header.time >= dayEnd)) {
+                auto logTime = LogTime::create_usec(static_cast<uint64_t>(std::max(header.time, int64_t{0})));
+                auto local = logTime.getLocalTime();
+                auto sinceMidnight = local - std::chrono::floor<std::chrono::days>(local);
+                dayStart = header.time - std::chrono::duration_cast<std::chrono::microseconds>(sinceMidnight).count();
+                dayEnd = dayStart + DAY_USEC - HOUR_USEC;   // check the last hour, as days with a dst change are shorter
+                map.emplace(logTime.toDays(), pos);         // keeps the first
+            }
+            stream->ignore(header.length);
+            pos += sizeof(header) + header.length;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout << "LogViewBinary::groupDays"
+                  << " path " << path
+                  << " end " << e.what() << std::endl;
+    }
+    return map;
+}
+
+LogViewBinaryIterator::LogViewBinaryIterator(const std::list<pLogViewIdentifier>& query, const pLogViewFile& logViewFile)
+: LogViewFileIterator::LogViewFileIterator(query, logViewFile)
+{
+    if (m_pos == std::numeric_limits<uint64_t>::max()) {
+        return;
+    }
+    try {   // the locations are described before their first use, so collect the skipped ones
+        uint64_t start = m_pos;
+        m_stat->seekg(0, std::ios_base::beg);
+        if (!LogViewBinary::readMagic(*m_stat)) {
+            m_pos = std::numeric_limits<uint64_t>::max();
+            return;
+        }
+        uint64_t pos = BinaryPlugin::MAGIC.size();
+        BinaryRecordHeader header;
+        while (pos < start) {
+            LogViewBinary::readHeader(*m_stat, header);
+            if (header.type == BinaryRecordType::Location) {
+                LogViewBinary::readLocation(*m_stat, header, m_locations);
+            }
+            else {
+                m_stat->ignore(header.length);
+            }
+            pos += sizeof(header) + header.length;
+        }
+    }
+    catch (const std::ios_base::failure& e) {
+        m_pos = std::numeric_limits<uint64_t>::max();
+    }
+}
+
+LogViewEntry
+LogViewBinaryIterator::parse()
+{
+    BinaryRecordHeader header;
+    LogViewBinary::readHeader(*m_stat, header);
+    while (header.type != BinaryRecordType::Entry) {
+        if (header.type == BinaryRecordType::Location) {
+            LogViewBinary::readLocation(*m_stat, header, m_locations);
+        }
+        else {  // unknown, skip
+            m_stat->ignore(header.length);
+        }
+        LogViewBinary::readHeader(*m_stat, header);
+    }
+    std::string message(header.length, '\0');
+    m_stat->read(message.data(), message.length());
+    LogViewEntry logViewEntry;
+    logViewEntry.setLocalTime(LogTime::create_usec(static_cast<uint64_t>(std::max(header.time, int64_t{0}))));
+    logViewEntry.setLevel(static_cast<Level>(header.level));
+    logViewEntry.setMessage(message);
+    if (header.location < m_locations.size()) {
+        logViewEntry.setLocation(m_locations[header.location]);
+    }
+    return logViewEntry;
+}
+
+
+} /* namespace log */
+} /* namespace psc */
@@ -17,11 +17,18 @@
  */
 
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cctype>
 #include <sys/types.h>
 #include <glibmm.h>     // using Glib::get_home_dir
 
 #include "StringUtils.hpp"
 #include "LogViewFile.hpp"
+#include "Parallel.hpp"
 
 
 namespace psc {
@@ -42,8 +49,7 @@ LogViewFile::getIdentifiers()
     for (const auto& entry : std::filesystem::directory_iterator(getBasePath())) {
         if (entry.is_regular_file()) {
             auto path = entry.path();
-            auto ext = path.extension();
-            if (LOG_EXTENSTION == ext) {     // avoid reading binary files
+            if (isListed(path)) {     // avoid reading binary files
                 std::string dir = entry.path().parent_path().string();
                 std::string file = entry.path().filename().string();
                 std::map<LogDays, uint64_t> mapDays = groupDays(entry.path());
@@ -74,50 +80,158 @@ LogViewFile::getIdentifiers()
 }
 
 // as we already doing the effort of scanning the file,
-//   do not optimize (no skipping), but record the position of each day
+//   do not optimize (no skipping), but record the position of each day.
+//   Larger files are split into byte ranges that are scanned in parallel.
 std::map<LogDays, uint64_t>
 LogViewFile::groupDays(const std::filesystem::path& path)
 {
     std::map<LogDays, uint64_t> map;
-    std::ifstream stat;
-    std::ios_base::iostate exceptionMask = stat.exceptions() | std::ios::failbit | std::ios::badbit | std::ios::eofbit;
-    stat.exceptions(exceptionMask);
     try {
-        stat.open(path.generic_string()); // open in text-mode
-        //std::cout << "reading " << path << std::endl;
-        while (!stat.eof()) {
-            auto pos = stat.tellg();        // capture position for start of line
-            std::string line;
-            std::getline(stat, line);
-            if (line.length() >= 1 && line[0] == ' ') {    // specific for LogViewFile (skip location)
-                if (stat.eof()) {
-                    break;
-                }
-                std::getline(stat, line);
+        if (isCompressed(path)) {   // no random access, scan at once
+            groupDays(path, 0u, std::numeric_limits<uint64_t>::max(), map);
+            return map;
+        }
+        auto size = std::filesystem::file_size(path);
+        map = psc::util::parallel_reduce(0u, size, PARALLEL_BYTES, map
+            , [&] (size_t lo, size_t hi, std::map<LogDays, uint64_t>& partial) {
+                groupDays(path, lo, hi, partial);
             }
-            //std::cout << "parsing " << line << std::endl;
-            auto logViewFile = parse(line);
-            if (logViewFile.getLocalTime().isValid()) {
-                auto dayDate = logViewFile.getLocalTime().toDays();
-                //std::cout << "dayDate " << dayDate <<std::endl;
-                auto exist = map.find(dayDate);
-                if (exist == map.end()) {
-                    map.insert(std::pair(dayDate, pos));
+            , [] (std::map<LogDays, uint64_t>& result, const std::map<LogDays, uint64_t>& partial) {
+                for (auto& entry : partial) {   // keep the first position of each day
+                    auto exist = result.find(entry.first);
+                    if (exist == result.end()) {
+                        result.insert(entry);
+                    }
+                    else if (entry.second < exist->second) {
+                        exist->second = entry.second;
+                    }
                 }
+            });
+    }
+    catch (const std::exception& e) {
+        std::cout << "LogViewFile::groupDays"
+                  << " path " << path
+                  << " end " << e.what() << std::endl;
+    }
+    return map;
+}
+
+// scan the lines that start within [lo, hi)
+void
+LogViewFile::groupDays(const std::filesystem::path& path, uint64_t lo, uint64_t hi, std::map<LogDays, uint64_t>& map)
+{
+    auto stream = openStream(path);
+    auto& stat = *stream;
+    std::string line;
+    uint64_t pos = lo;
+    if (lo > 0) {   // a line running into lo belongs to the previous range
+        stat.seekg(lo - 1);
+        if (!std::getline(stat, line)) {
+            return;
+        }
+        pos = lo - 1 + line.length() + 1;
+    }
+    // FilePlugin::format writes a debug entry as the function line (indented)
+    //   followed by the entry line, so the entry starts with its function line
+    int64_t function = -1;
+    while (std::getline(stat, line)) {
+        auto lineStart = pos;
+        pos += line.length() + 1;
+        if (lineStart >= hi && function < 0) {
+            break;
+        }
+        if (line.length() >= 1 && line[0] == ' ') {    // specific for LogViewFile (function line)
+            if (lineStart >= hi) {
+                break;
+            }
+            function = static_cast<int64_t>(lineStart);
+            continue;
+        }
+        // capture position for start of entry
+        auto start = function >= 0 ? static_cast<uint64_t>(function) : lineStart;
+        function = -1;
+        //std::cout << "parsing " << line << std::endl;
+        auto logViewFile = parse(line);
+        if (logViewFile.getLocalTime().isValid()) {
+            auto dayDate = logViewFile.getLocalTime().toDays();
+            // the map may hold results of other ranges, keep the first
+            auto exist = map.find(dayDate);
+            if (exist == map.end()) {
+                map.insert(std::pair(dayDate, start));
             }
+            else if (start < exist->second) {
+                exist->second = start;
+            }
+        }
+        if (lineStart >= hi) {      // was the entry of our last function line
+            break;
         }
     }
-    catch (const std::exception& e) {
-        if (!stat.eof()) {
-            std::cout << "LogViewFile::groupDays"
-                      << " path " << path
-                      << " end " << e.what() << std::endl;
+}
+
+// name.log and the rotated generations name.log.N, name.log.N.gz
+bool
+LogViewFile::isLogFile(const std::filesystem::path& path, const char* extension)
+{
+    auto name = path.filename().string();
+    auto pos = name.rfind(extension);
+    if (pos == name.npos) {
+        return false;
+    }
+    auto generation = name.substr(pos + std::strlen(extension));
+    if (generation.empty()) {
+        return true;
+    }
+    if (isCompressed(path)) {
+        generation.resize(generation.length() - std::strlen(FilePlugin::COMPRESSED_EXTENSION));
+    }
+    return generation.length() >= 2
+        && generation[0] == '.'
+        && std::all_of(generation.begin() + 1, generation.end(), [] (char c) {
+            return std::isdigit(static_cast<unsigned char>(c));
+        });
+}
+
+bool
+LogViewFile::isListed(const std::filesystem::path& path)
+{
+    return isLogFile(path);
+}
+
+bool
+LogViewFile::isCompressed(const std::filesystem::path& path)
+{
+    return path.extension() == FilePlugin::COMPRESSED_EXTENSION;
+}
+
+// the compressed generations are limited in size (by FilePlugin),
+//   so they are decompressed to memory, this keeps the positions usable for seeking
+std::unique_ptr<std::istream>
+LogViewFile::openStream(const std::filesystem::path& path)
+{
+    if (isCompressed(path)) {
+        try {
+            auto file = Gio::File::create_for_path(path.string());
+            auto decompressor = Gio::ZlibDecompressor::create(Gio::ZlibCompressorFormat::ZLIB_COMPRESSOR_FORMAT_GZIP);
+            auto instream = Gio::ConverterInputStream::create(file->read(), decompressor);
+            std::string content;
+            std::array<char, 16u*1024u> buf;
+            gssize read;
+            while ((read = instream->read(buf.data(), buf.size())) > 0) {
+                content.append(buf.data(), static_cast<size_t>(read));
+            }
+            instream->close();
+            return std::make_unique<std::istringstream>(std::move(content));
+        }
+        catch (const Glib::Error& ex) {
+            throw std::runtime_error("unable to decompress " + ex.what());
         }
     }
-    if (stat.is_open()) {
-        stat.close();
+    auto stat = std::make_unique<std::ifstream>(path.string()); // open in text-mode
+    if (!stat->is_open()) {
+        throw std::runtime_error("unable to open");
     }
-    return map;
+    return stat;
 }
 
 std::string
@@ -184,6 +298,15 @@ LogViewFile::parse(const std::string& line)
             auto levelName = line.substr(levelStart, levelEnd-levelStart);
             level = Log::getLevel(levelName);
             ++levelEnd;
+            // skip the optional thread e.g. "[3] "
+            if (levelEnd < line.length() && line[levelEnd] == '[') {
+                auto threadEnd = line.find("] ", levelEnd);
+                if (threadEnd != line.npos
+                 && threadEnd > levelEnd + 1
+                 && line.find_first_not_of("0123456789", levelEnd + 1) == threadEnd) {
+                    levelEnd = threadEnd + 2;
+                }
+            }
             std::string message = line.substr(levelEnd);
             StringUtils::ltrim(message);
             logViewEntry.setLocalTime(timestamp);
@@ -262,15 +385,15 @@ LogViewFileIterator::LogViewFileIterator(const std::list<pLogViewIdentifier>& qu
             pos = (*posEntry).second;
         }
     }
-    std::ios_base::iostate exceptionMask = m_stat.exceptions() | std::ios::failbit | std::ios::badbit | std::ios::eofbit;
-    m_stat.exceptions(exceptionMask);
     try {
         auto fileSize = std::filesystem::file_size(path);
-        m_stat.open(path.string()); // open in text-mode
+        m_stat = LogViewFile::openStream(path);
+        std::ios_base::iostate exceptionMask = m_stat->exceptions() | std::ios::failbit | std::ios::badbit | std::ios::eofbit;
+        m_stat->exceptions(exceptionMask);
         m_pos = 0l;
         if (pos > 0ul
          && fileSize >= nameId->getFileSize()) {    // if file has been rolled over, don't skip
-            m_stat.seekg(pos, std::ios_base::beg);
+            m_stat->seekg(pos, std::ios_base::beg);
             m_pos = pos;
         }
     }
@@ -282,13 +405,6 @@ LogViewFileIterator::LogViewFileIterator(const std::list<pLogViewIdentifier>& qu
     }
 }
 
-LogViewFileIterator::~LogViewFileIterator()
-{
-    if (m_stat.is_open()) {
-        m_stat.close();
-    }
-}
-
 LogViewFileIterator::value_type
 LogViewFileIterator::get() const
 {
@@ -299,7 +415,7 @@ void
 LogViewFileIterator::inc()
 {
     if (m_pos < std::numeric_limits<uint64_t>::max()
-     && !m_stat.eof()) {
+     && !m_stat->eof()) {
         try {
             LogDays logDay;
             do {
@@ -349,13 +465,13 @@ LogViewFileIterator::parse()
     //2024-10-19 17:22:05.996 Deb          Weather.cpp: 45 pixbuf stream 0x5dd68664f480
     //                               Glib::RefPtr<Gdk::Pixbuf> WeatherImageRequest::get_pixbuf()
     std::string line;
-    std::getline(m_stat, line);
+    std::getline(*m_stat, line);
     if (line.length() >= 1 && line[0] == ' ') {    // guess we hit a location line
-        std::getline(m_stat, line); // so try again
+        std::getline(*m_stat, line); // so try again
     }
     auto logViewEntry = m_logViewFile->parse(line);
-    if (m_stat.peek() == ' ') {
-        std::getline(m_stat, line);
+    if (m_stat->peek() == ' ') {
+        std::getline(*m_stat, line);
         StringUtils::ltrim(line);
         logViewEntry.setLocation(line);
     }
@@ -141,7 +141,7 @@ LogViewEntry
 LogViewSyslogIterator::parse()
 {
     std::string line;
-    std::getline(m_stat, line);
+    std::getline(*m_stat, line);
     return m_logViewFile->parse(line);
 }
 
@@ -17,12 +17,20 @@
  */
 
 
+#include <iostream>
+#include <algorithm>
+
 #include "Mode.hpp"
+#include "NavigationList.hpp"
 
 PagingMode::PagingMode(int32_t front, std::vector<Glib::RefPtr<Gio::File>>& picts)
 : m_front{front}
 , m_picts{picts}
 {
+    m_sortKeys.reserve(m_picts.size());
+    for (auto& file : m_picts) {
+        m_sortKeys.push_back(getSortKey(file));
+    }
 }
 
 Glib::RefPtr<Gio::File>
@@ -45,22 +53,23 @@ PagingMode::show(ViewIntf* viewIntf)
 }
 
 void
-PagingMode::buildMenu(Gtk::Menu* subMenu, ViewIntf* imageView, function_ptr fun)
+PagingMode::buildMenu(Gtk::Menu* popupMenu, ViewIntf* imageView, function_ptr fun)
 {
-    int32_t n = 0;
-    for (auto p : m_picts)  {
-        Glib::ustring name = p->get_basename();
-        auto lastN = Gtk::make_managed<Gtk::MenuItem>(name, true);
-        lastN->signal_activate().connect(
-            sigc::bind(sigc::mem_fun(*imageView, fun), n));
-        subMenu->append(*lastN);
-        ++n;
-    }
+    // a single entry, the files are listed on demand (as there may be many of them)
+    auto view = Gtk::make_managed<Gtk::MenuItem>("_View...", true);
+    view->signal_activate().connect(
+        [this, imageView, fun] {
+            NavigationDialog::choose(this, imageView, fun);
+        });
+    popupMenu->append(*view);
 }
 
 void
 PagingMode::next()
 {
+    if (m_picts.empty()) {
+        return;
+    }
     ++m_front;
     m_front %= static_cast<int32_t>(m_picts.size());
 }
@@ -68,6 +77,9 @@ PagingMode::next()
 void
 PagingMode::prev()
 {
+    if (m_picts.empty()) {
+        return;
+    }
     --m_front;
     if (m_front < 0) {
         m_front += static_cast<uint32_t>(m_picts.size());
@@ -77,6 +89,9 @@ PagingMode::prev()
 void
 PagingMode::set(int32_t n)
 {
+    if (m_picts.empty()) {
+        return;
+    }
     m_front = n;
     m_front %= static_cast<uint32_t>(m_picts.size());
 }
@@ -100,6 +115,18 @@ PagingMode::getPicts()
     return m_picts;
 }
 
+size_t
+PagingMode::size()
+{
+    return m_picts.size();
+}
+
+Glib::RefPtr<Gio::File>
+PagingMode::getFile(size_t idx)
+{
+    return m_picts[idx];
+}
+
 bool
 PagingMode::join(std::shared_ptr<Mode> other)
 {
@@ -108,6 +135,7 @@ PagingMode::join(std::shared_ptr<Mode> other)
         m_front = static_cast<int32_t>(m_picts.size()) + add->get();
         for (auto file : add->getPicts()) {
             m_picts.push_back(file);
+            m_sortKeys.push_back(getSortKey(file));
         }
         return true;
     }
@@ -119,3 +147,208 @@ PagingMode::hasNavigation()
 {
     return m_picts.size() > 1;
 }
+
+Glib::ustring
+PagingMode::getSortName(const Glib::RefPtr<Gio::File>& file)
+{
+    // same as the display-name used for the initial sorting
+    return Glib::filename_display_basename(file->get_path());
+}
+
+std::string
+PagingMode::getSortKey(const Glib::RefPtr<Gio::File>& file)
+{
+    // byte-wise comparison of the keys gives the order of the ustring compare
+    return getSortName(file).collate_key();
+}
+
+std::vector<Glib::RefPtr<Gio::File>>::iterator
+PagingMode::lowerBound(const std::string& sortKey)
+{
+    auto keyIter = std::lower_bound(m_sortKeys.begin(), m_sortKeys.end(), sortKey);
+    return m_picts.begin() + (keyIter - m_sortKeys.begin());
+}
+
+bool
+PagingMode::add(const Glib::RefPtr<Gio::File>& file)
+{
+    auto sortKey = getSortKey(file);
+    auto iter = lowerBound(sortKey);
+    if (iter != m_picts.end()
+     && (*iter)->equal(file)) {
+        return false;   // already known e.g. created and moved in
+    }
+    auto pos = static_cast<int32_t>(iter - m_picts.begin());
+    m_picts.insert(iter, file);
+    m_sortKeys.insert(m_sortKeys.begin() + pos, std::move(sortKey));
+    if (m_picts.size() > 1
+     && pos <= m_front) {
+        ++m_front;      // keep showing the same file
+    }
+    return true;
+}
+
+bool
+PagingMode::remove(const Glib::RefPtr<Gio::File>& file)
+{
+    auto sortKey = getSortKey(file);
+    for (auto iter = lowerBound(sortKey); iter != m_picts.end(); ++iter) {
+        auto pos = static_cast<int32_t>(iter - m_picts.begin());
+        if ((*iter)->equal(file)) {
+            m_picts.erase(iter);
+            m_sortKeys.erase(m_sortKeys.begin() + pos);
+            if (pos < m_front) {
+                --m_front;
+            }
+            // if the front was removed show the following
+            if (m_front >= static_cast<int32_t>(m_picts.size())) {
+                m_front = 0;
+            }
+            return true;
+        }
+        if (m_sortKeys[pos] != sortKey) {
+            break;
+        }
+    }
+    return false;
+}
+
+bool
+PagingMode::contains(const Glib::RefPtr<Gio::File>& file)
+{
+    auto sortKey = getSortKey(file);
+    for (auto iter = lowerBound(sortKey); iter != m_picts.end(); ++iter) {
+        if ((*iter)->equal(file)) {
+            return true;
+        }
+        if (m_sortKeys[iter - m_picts.begin()] != sortKey) {
+            break;
+        }
+    }
+    return false;
+}
+
+bool
+PagingMode::rename(const Glib::RefPtr<Gio::File>& file, const Glib::RefPtr<Gio::File>& renamed)
+{
+    auto front = getFrontFile();
+    bool wasFront = front && front->equal(file);
+    bool removed = remove(file);
+    bool added = add(renamed);
+    if (wasFront && added) {
+        auto iter = lowerBound(getSortKey(renamed));
+        m_front = static_cast<int32_t>(iter - m_picts.begin());
+    }
+    return removed || added;
+}
+
+DirMode::DirMode(const Glib::RefPtr<Gio::File>& dir
+                , std::vector<Glib::RefPtr<Gio::File>>& picts
+                , const std::function<bool(const Glib::RefPtr<Gio::File>&)>& accept)
+: PagingMode(0, picts)
+, m_dir{dir}
+, m_accept{accept}
+{
+    try {
+        m_monitor = m_dir->monitor_directory(Gio::FileMonitorFlags::FILE_MONITOR_WATCH_MOVES);
+        m_monitorConn = m_monitor->signal_changed().connect(
+                sigc::mem_fun(*this, &DirMode::on_dir_changed));
+    }
+    catch (const Glib::Error& ex) {
+        // not all filesystems support monitoring, so go on without updates
+        std::cerr << "DirMode::DirMode no monitor for " << m_dir->get_path()
+                  << " " << ex.what() << std::endl;
+    }
+}
+
+DirMode::~DirMode()
+{
+    unwatch();
+}
+
+void
+DirMode::unwatch()
+{
+    if (m_monitor) {
+        m_monitorConn.disconnect();
+        m_monitor->cancel();
+        m_monitor.reset();
+    }
+}
+
+Glib::RefPtr<Gio::File>
+DirMode::getDir()
+{
+    return m_dir;
+}
+
+sigc::signal<void>
+DirMode::signal_changed()
+{
+    return m_signal_changed;
+}
+
+sigc::signal<void>
+DirMode::signal_front_changed()
+{
+    return m_signal_front_changed;
+}
+
+bool
+DirMode::join(std::shared_ptr<Mode> other)
+{
+    bool joined = PagingMode::join(other);
+    if (joined) {
+        unwatch();      // the list is no longer just the directory (nor sorted)
+    }
+    return joined;
+}
+
+void
+DirMode::on_dir_changed(const Glib::RefPtr<Gio::File>& file
+                      , const Glib::RefPtr<Gio::File>& otherFile
+                      , Gio::FileMonitorEvent event)
+{
+    bool changed = false;
+    auto front = getFrontFile();
+    bool frontRemoved = false;
+    switch (event) {
+    case Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CREATED:
+    case Gio::FileMonitorEvent::FILE_MONITOR_EVENT_MOVED_IN:
+        if (m_accept(file)) {
+            changed = add(file);
+        }
+        break;
+    case Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CHANGED:
+    case Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+        // a created file may have been rejected while it was empty (e.g. copied or scanned),
+        //   so check again as the content arrives
+        if (!contains(file)
+         && m_accept(file)) {
+            changed = add(file);
+        }
+        break;
+    case Gio::FileMonitorEvent::FILE_MONITOR_EVENT_DELETED:
+    case Gio::FileMonitorEvent::FILE_MONITOR_EVENT_MOVED_OUT:
+        changed = remove(file);
+        frontRemoved = changed && front && front->equal(file);
+        break;
+    case Gio::FileMonitorEvent::FILE_MONITOR_EVENT_RENAMED:
+        if (otherFile && m_accept(otherFile)) {
+            changed = rename(file, otherFile);
+        }
+        else {
+            changed = remove(file);     // e.g. renamed to a unknown extension
+            frontRemoved = changed && front && front->equal(file);
+        }
+        break;
+    default:
+        break;
+    }
+    if (changed) {
+        m_signal_changed.emit();
+    }
+    if (frontRemoved) {
+        m_signal_front_changed.emit();
+    }
+}
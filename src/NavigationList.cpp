@@ -0,0 +1,395 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <algorithm>
+
+#include "NavigationList.hpp"
+
+PagingColumns PagingListModel::m_columns;
+
+PagingListModel::PagingListModel(PagingMode* mode, const Glib::ustring& filter, const PagingListModel* previous)
+: Glib::ObjectBase(typeid(PagingListModel)) // Register a custom GType.
+, Glib::Object() // The custom GType is actually registered here.
+, m_mode{mode}
+, m_filter{filter.casefold()}
+{
+    auto size = static_cast<int32_t>(m_mode->size());
+    if (m_filter.empty()) {
+        m_count = size;
+    }
+    else {
+        m_filtered = true;
+        auto matches = [&] (int32_t i) {
+            auto name = PagingMode::getSortName(m_mode->getFile(i));
+            return name.casefold().find(m_filter) != Glib::ustring::npos;
+        };
+        // any name containing the extended filter contains the previous as well
+        if (previous
+         && previous->m_mode == m_mode
+         && previous->m_filtered
+         && m_filter.find(previous->m_filter) != Glib::ustring::npos) {
+            for (auto i : previous->m_rows) {
+                if (i < size && matches(i)) {
+                    m_rows.push_back(i);
+                }
+            }
+        }
+        else {
+            for (int32_t i = 0; i < size; ++i) {
+                if (matches(i)) {
+                    m_rows.push_back(i);
+                }
+            }
+        }
+        m_count = static_cast<int32_t>(m_rows.size());
+    }
+}
+
+Glib::RefPtr<PagingListModel>
+PagingListModel::create(PagingMode* mode, const Glib::ustring& filter, const Glib::RefPtr<PagingListModel>& previous)
+{
+    return Glib::RefPtr<PagingListModel>(new PagingListModel(mode, filter, previous.get()));
+}
+
+int32_t
+PagingListModel::toIndex(int32_t row) const
+{
+    if (row < 0 || row >= m_count) {
+        return -1;
+    }
+    int32_t index = m_filtered ? m_rows[row] : row;
+    // the mode may have shrunk (use a fresh model on change)
+    if (static_cast<size_t>(index) >= m_mode->size()) {
+        return -1;
+    }
+    return index;
+}
+
+int32_t
+PagingListModel::getIndex(const Gtk::TreeModel::Path& path) const
+{
+    if (path.size() != 1) {
+        return -1;
+    }
+    return toIndex(path[0]);
+}
+
+int32_t
+PagingListModel::getRow(int32_t index) const
+{
+    if (!m_filtered) {
+        return index < m_count ? index : -1;
+    }
+    auto iter = std::lower_bound(m_rows.begin(), m_rows.end(), index);
+    if (iter != m_rows.end() && *iter == index) {
+        return static_cast<int32_t>(iter - m_rows.begin());
+    }
+    return -1;
+}
+
+int32_t
+PagingListModel::getRowCount() const
+{
+    return m_count;
+}
+
+Gtk::TreeModelFlags
+PagingListModel::get_flags_vfunc() const
+{
+   return Gtk::TreeModelFlags::TREE_MODEL_LIST_ONLY;
+}
+
+int
+PagingListModel::get_n_columns_vfunc() const
+{
+   return m_columns.size();
+}
+
+GType
+PagingListModel::get_column_type_vfunc(int index) const
+{
+    if (index < 0 || static_cast<size_t>(index) >= m_columns.size()) {
+        return 0;
+    }
+    return m_columns.types()[index];
+}
+
+void
+PagingListModel::get_value_vfunc(const const_iterator& iter, int column, Glib::ValueBase& value) const
+{
+    if (!is_valid(iter)) {
+        return;
+    }
+    auto row = static_cast<int32_t>(GPOINTER_TO_INT(iter.gobj()->user_data));
+    auto index = toIndex(row);
+    if (column == m_columns.m_name.index()) {
+        Glib::ustring name;
+        if (index >= 0) {
+            name = PagingMode::getSortName(m_mode->getFile(index));   // resolve name when shown
+        }
+        Glib::Value<Glib::ustring> nameValue;
+        nameValue.init(Glib::Value<Glib::ustring>::value_type());
+        nameValue.set(name);
+        value.init(Glib::Value<Glib::ustring>::value_type());
+        value = nameValue;
+    }
+    else if (column == m_columns.m_index.index()) {
+        Glib::Value<int> indexValue;
+        indexValue.init(Glib::Value<int>::value_type());
+        indexValue.set(index);
+        value.init(Glib::Value<int>::value_type());
+        value = indexValue;
+    }
+}
+
+bool
+PagingListModel::iter_next_vfunc(const iterator& iter, iterator& iter_next) const
+{
+    auto row = static_cast<int32_t>(GPOINTER_TO_INT(iter.gobj()->user_data));
+    if (!is_valid(iter)
+     || row + 1 >= m_count) {
+        iter_next = iterator();
+        return false;
+    }
+    iter_next.set_stamp(m_stamp);
+    iter_next.gobj()->user_data = GINT_TO_POINTER(row + 1);
+    return true;
+}
+
+// a list has no children
+bool
+PagingListModel::iter_children_vfunc(const iterator& parent, iterator& iter) const
+{
+    iter = iterator();
+    return false;
+}
+
+bool
+PagingListModel::iter_has_child_vfunc(const const_iterator& iter) const
+{
+    return false;
+}
+
+int
+PagingListModel::iter_n_children_vfunc(const const_iterator& iter) const
+{
+    return 0;
+}
+
+int
+PagingListModel::iter_n_root_children_vfunc() const
+{
+    return m_count;
+}
+
+bool
+PagingListModel::iter_nth_child_vfunc(const iterator& parent, int n, iterator& iter) const
+{
+    iter = iterator();
+    return false;
+}
+
+bool
+PagingListModel::iter_nth_root_child_vfunc(int n, iterator& iter) const
+{
+    if (n < 0 || n >= m_count) {
+        iter = iterator();
+        return false;
+    }
+    iter.set_stamp(m_stamp);
+    iter.gobj()->user_data = GINT_TO_POINTER(n);
+    return true;
+}
+
+bool
+PagingListModel::iter_parent_vfunc(const iterator& child, iterator& iter) const
+{
+    iter = iterator();
+    return false;
+}
+
+Gtk::TreeModel::Path
+PagingListModel::get_path_vfunc(const const_iterator& iter) const
+{
+    Path path;
+    path.push_back(GPOINTER_TO_INT(iter.gobj()->user_data));
+    return path;
+}
+
+bool
+PagingListModel::get_iter_vfunc(const Path& path, iterator& iter) const
+{
+    if (path.size() != 1
+     || path[0] < 0
+     || path[0] >= m_count) {
+        iter = iterator();
+        return false;
+    }
+    iter.set_stamp(m_stamp);
+    iter.gobj()->user_data = GINT_TO_POINTER(path[0]);
+    return true;
+}
+
+bool
+PagingListModel::is_valid(const const_iterator& iter) const
+{
+    return m_stamp == iter.get_stamp();
+}
+
+
+NavigationDialog::NavigationDialog(Gtk::Window* parent, PagingMode* mode)
+: Gtk::Dialog("View")
+, m_mode{mode}
+{
+    if (parent) {
+        set_transient_for(*parent);
+    }
+    set_modal(true);
+    set_default_size(320, 480);
+    add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+    add_button("_Open", Gtk::RESPONSE_OK);
+
+    m_search.signal_search_changed().connect(
+            sigc::mem_fun(*this, &NavigationDialog::on_search_changed));
+    m_search.signal_activate().connect(
+            sigc::mem_fun(*this, &NavigationDialog::on_search_activate));
+    get_content_area()->pack_start(m_search, false, false);
+
+    m_view.set_headers_visible(false);
+    auto column = Gtk::make_managed<Gtk::TreeViewColumn>("Name", PagingListModel::m_columns.m_name);
+    column->set_sizing(Gtk::TreeViewColumnSizing::TREE_VIEW_COLUMN_FIXED);
+    m_view.append_column(*column);
+    m_view.set_fixed_height_mode(true);    // otherwise each row is measured
+    m_view.set_enable_search(false);       // we have our own
+    m_view.signal_row_activated().connect(
+            sigc::mem_fun(*this, &NavigationDialog::on_row_activated));
+    m_scroll.set_policy(Gtk::PolicyType::POLICY_NEVER, Gtk::PolicyType::POLICY_AUTOMATIC);
+    m_scroll.add(m_view);
+    get_content_area()->pack_start(m_scroll, true, true);
+
+    auto dirMode = dynamic_cast<DirMode*>(mode);
+    if (dirMode) {
+        dirMode->signal_changed().connect(
+                sigc::mem_fun(*this, &NavigationDialog::on_mode_changed));
+    }
+    m_model = PagingListModel::create(m_mode);
+    m_view.set_model(m_model);
+    select(m_mode->get());
+    show_all_children();
+    m_search.grab_focus();
+}
+
+NavigationDialog::~NavigationDialog()
+{
+    m_filterTimer.disconnect();
+}
+
+void
+NavigationDialog::select(int32_t index)
+{
+    auto row = m_model->getRow(index);
+    if (row < 0 && m_model->getRowCount() > 0) {
+        row = 0;
+    }
+    if (row >= 0) {
+        Gtk::TreeModel::Path path;
+        path.push_back(row);
+        m_view.set_cursor(path);
+        m_view.scroll_to_row(path, 0.5f);
+    }
+}
+
+void
+NavigationDialog::applyFilter(bool narrow)
+{
+    m_filterTimer.disconnect();
+    m_model = PagingListModel::create(m_mode, m_search.get_text()
+                                    , narrow ? m_model : Glib::RefPtr<PagingListModel>());
+    m_view.set_model(m_model);
+    select(m_mode->get());
+}
+
+void
+NavigationDialog::on_search_changed()
+{
+    m_filterTimer.disconnect();
+    m_filterTimer = Glib::signal_timeout().connect(
+        [this] {
+            applyFilter(true);
+            return false;
+        }, FILTER_DELAY_MS);
+}
+
+void
+NavigationDialog::on_mode_changed()
+{
+    applyFilter(false);    // rebuild with the current filter
+}
+
+void
+NavigationDialog::on_search_activate()
+{
+    if (m_filterTimer.connected()) {
+        applyFilter(true);  // typed and activated without a pause
+    }
+    Gtk::TreeModel::Path path;
+    Gtk::TreeViewColumn* column;
+    m_view.get_cursor(path, column);
+    if (!path.empty()) {
+        on_row_activated(path, column);
+    }
+}
+
+void
+NavigationDialog::on_row_activated(const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* column)
+{
+    m_selected = m_model->getIndex(path);
+    if (m_selected >= 0) {
+        response(Gtk::RESPONSE_OK);
+    }
+}
+
+int32_t
+NavigationDialog::getSelected()
+{
+    if (m_selected < 0) {
+        Gtk::TreeModel::Path path;
+        Gtk::TreeViewColumn* column;
+        m_view.get_cursor(path, column);
+        if (!path.empty()) {
+            m_selected = m_model->getIndex(path);
+        }
+    }
+    return m_selected;
+}
+
+void
+NavigationDialog::choose(PagingMode* mode, ViewIntf* imageView, function_ptr fun)
+{
+    auto parent = dynamic_cast<Gtk::Window*>(imageView);
+    NavigationDialog dialog(parent, mode);
+    int result = dialog.run();
+    dialog.hide();
+    if (result == Gtk::RESPONSE_OK) {
+        auto index = dialog.getSelected();
+        if (index >= 0) {
+            (imageView->*fun)(index);
+        }
+    }
+}
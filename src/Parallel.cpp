@@ -0,0 +1,201 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+#include "Parallel.hpp"
+
+namespace psc::util {
+
+// the part of a participant, others may steal from the back
+class WorkRange
+{
+public:
+    void set(size_t lo, size_t hi)
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_lo = lo;
+        m_hi = hi;
+    }
+    bool take(size_t grain, size_t& lo, size_t& hi)
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (m_lo >= m_hi) {
+            return false;
+        }
+        lo = m_lo;
+        hi = std::min(m_hi, m_lo + grain);
+        m_lo = hi;
+        return true;
+    }
+    bool steal(size_t grain, size_t& lo, size_t& hi)
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (m_lo >= m_hi) {
+            return false;
+        }
+        auto left = m_hi - m_lo;
+        auto half = left > grain ? left / 2 : left;
+        lo = m_hi - half;
+        hi = m_hi;
+        m_hi = lo;
+        return true;
+    }
+private:
+    std::mutex m_mutex;
+    size_t m_lo{};
+    size_t m_hi{};
+};
+
+// shared with the helpers, as these may start after we are done
+class ParallelState
+{
+public:
+    ParallelState(uint32_t slots, size_t grain
+                , const std::function<void(uint32_t slot, size_t lo, size_t hi)>& fun)
+    : m_ranges(slots)
+    , m_grain{grain}
+    , m_fun{fun}
+    {
+    }
+    void distribute(size_t begin, size_t end)
+    {
+        auto slots = m_ranges.size();
+        auto size = end - begin;
+        for (size_t i = 0; i < slots; ++i) {
+            m_ranges[i].set(begin + size * i / slots, begin + size * (i + 1) / slots);
+        }
+    }
+    void help(uint32_t slot)
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (m_closed) {     // started too late, nothing left
+                return;
+            }
+            ++m_active;
+        }
+        participate(slot);
+        std::lock_guard<std::mutex> lock{m_mutex};
+        --m_active;
+        m_condDone.notify_all();
+    }
+    void participate(uint32_t slot)
+    {
+        auto& own = m_ranges[slot];
+        size_t lo, hi;
+        while (!m_abort) {
+            if (!own.take(m_grain, lo, hi)) {
+                if (!stealFor(slot, lo, hi)) {
+                    break;
+                }
+                own.set(lo, hi);
+                continue;
+            }
+            try {
+                m_fun(slot, lo, hi);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                if (!m_eptr) {
+                    m_eptr = std::current_exception();
+                }
+                m_abort = true;
+            }
+        }
+    }
+    // called by the owner after its participation
+    void close()
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_closed = true;
+        m_condDone.wait(lock, [this] {
+            return m_active == 0u;
+        });
+        if (m_eptr) {
+            std::rethrow_exception(m_eptr);
+        }
+    }
+protected:
+    bool stealFor(uint32_t slot, size_t& lo, size_t& hi)
+    {
+        auto slots = static_cast<uint32_t>(m_ranges.size());
+        for (uint32_t i = 1; i < slots; ++i) {
+            auto& victim = m_ranges[(slot + i) % slots];
+            if (victim.steal(m_grain, lo, hi)) {
+                return true;
+            }
+        }
+        return false;
+    }
+private:
+    std::vector<WorkRange> m_ranges;
+    size_t m_grain;
+    std::function<void(uint32_t slot, size_t lo, size_t hi)> m_fun;
+    std::mutex m_mutex;
+    std::condition_variable m_condDone;
+    uint32_t m_active{};
+    bool m_closed{false};
+    std::atomic<bool> m_abort{false};
+    std::exception_ptr m_eptr;
+};
+
+uint32_t
+parallel_slots(size_t begin, size_t end, size_t grain, Executor& executor)
+{
+    if (end <= begin) {
+        return 1u;
+    }
+    grain = std::max(static_cast<size_t>(1u), grain);
+    auto chunks = (end - begin + grain - 1) / grain;
+    return static_cast<uint32_t>(std::min(static_cast<size_t>(executor.getThreads()) + 1u, chunks));
+}
+
+void
+parallel_run(size_t begin, size_t end, size_t grain, uint32_t slots
+           , const std::function<void(uint32_t slot, size_t lo, size_t hi)>& fun
+           , Priority priority
+           , Executor& executor)
+{
+    if (end <= begin) {
+        return;
+    }
+    grain = std::max(static_cast<size_t>(1u), grain);
+    if (slots <= 1u) {      // not worth the effort
+        for (size_t lo = begin; lo < end; lo += grain) {
+            fun(0u, lo, std::min(end, lo + grain));
+        }
+        return;
+    }
+    auto state = std::make_shared<ParallelState>(slots, grain, fun);
+    state->distribute(begin, end);
+    for (uint32_t slot = 1; slot < slots; ++slot) {
+        executor.submit(priority, [state, slot] {
+            state->help(slot);
+        });
+    }
+    state->participate(0u);
+    state->close();
+}
+
+} // namespace psc::util
@@ -21,6 +21,7 @@
 
 #include "PdfImage.hpp"
 #include "PdfExport.hpp"
+#include "Parallel.hpp"
 
 namespace psc::pdf
 {
@@ -59,18 +60,21 @@ PdfImage::load(const Cairo::RefPtr<Cairo::ImageSurface>& cimage)
     HPDF_UINT width = cimage->get_width();
     HPDF_UINT height = cimage->get_height();
     auto rgbPackedData = std::vector<uint8_t>(width * height * 3);
-    auto rgbPackedPtr = &rgbPackedData[0];
-    auto ptrCairoImg = reinterpret_cast<uint32_t*>(cimage->get_data());
-    for (uint32_t r = 0; r < height; ++r) {
-        for (uint32_t w = 0; w < width; ++w) {
-            auto argb = ptrCairoImg[w];
-            // tested with little-endian (intel) (unsure if this is correct for big endian?)
-            *rgbPackedPtr++ = ((argb >> 16) & 0xff);       // R
-            *rgbPackedPtr++ = ((argb >> 8) & 0xff);        // G
-            *rgbPackedPtr++ = (argb & 0xff);               // B
+    auto data = cimage->get_data();
+    auto stride = cimage->get_stride();
+    psc::util::parallel_for(0u, height, PARALLEL_ROWS, [&] (size_t lo, size_t hi) {
+        for (size_t r = lo; r < hi; ++r) {
+            auto rgbPackedPtr = &rgbPackedData[r * width * 3];
+            auto ptrCairoImg = reinterpret_cast<uint32_t*>(data + r * stride);
+            for (uint32_t w = 0; w < width; ++w) {
+                auto argb = ptrCairoImg[w];
+                // tested with little-endian (intel) (unsure if this is correct for big endian?)
+                *rgbPackedPtr++ = ((argb >> 16) & 0xff);       // R
+                *rgbPackedPtr++ = ((argb >> 8) & 0xff);        // G
+                *rgbPackedPtr++ = (argb & 0xff);               // B
+            }
         }
-        ptrCairoImg += width;
-    }
+    });
     //std::cout << "cimage " << width << " height " << height << std::endl;
     HPDF_Doc pdf = m_pdfExport->getDoc();
     m_image = HPDF_LoadRawImageFromMem(pdf,
@@ -0,0 +1,232 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "Pipeline.hpp"
+
+namespace psc::util {
+
+static int64_t
+steadyNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PipelineStage::PipelineStage(const std::string& name, uint32_t threads
+                           , const std::function<void()>& close
+                           , const std::function<size_t()>& queued
+                           , size_t capacity)
+: m_name{name}
+, m_threads{std::max(1u, threads)}
+, m_close{close}
+, m_queued{queued}
+, m_capacity{capacity}
+{
+}
+
+void
+PipelineStage::start(const std::function<void()>& work)
+{
+    m_start = steadyNanos();
+    m_running = m_threads;
+    m_workers.reserve(m_threads);
+    for (uint32_t i = 0; i < m_threads; ++i) {
+        m_workers.emplace_back(std::thread(&PipelineStage::run, this, work));
+    }
+}
+
+void
+PipelineStage::run(const std::function<void()>& work)
+{
+    work();
+    if (m_running.fetch_sub(1u) == 1u) {   // the last one
+        m_end = steadyNanos();
+        close();
+    }
+}
+
+void
+PipelineStage::join()
+{
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void
+PipelineStage::close()
+{
+    if (m_close) {
+        m_close();
+    }
+}
+
+void
+PipelineStage::addProcessed(std::chrono::steady_clock::duration latency)
+{
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+    ++m_processed;
+    m_sumLatency += nanos;
+    auto max = m_maxLatency.load(std::memory_order_relaxed);
+    while (nanos > max
+        && !m_maxLatency.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+void
+PipelineStage::addEmitted(std::chrono::steady_clock::duration blocked)
+{
+    ++m_emitted;
+    m_blocked += std::chrono::duration_cast<std::chrono::nanoseconds>(blocked).count();
+}
+
+uint32_t
+PipelineStage::getThreads() const
+{
+    return m_threads;
+}
+
+StageMetrics
+PipelineStage::getMetrics() const
+{
+    StageMetrics metrics;
+    metrics.name = m_name;
+    metrics.threads = m_threads;
+    metrics.processed = m_processed;
+    metrics.emitted = m_emitted;
+    metrics.queued = m_queued ? m_queued() : 0u;
+    metrics.capacity = m_capacity;
+    auto end = m_end.load();
+    auto elapsed = (end != 0 ? end : steadyNanos()) - m_start;
+    if (elapsed > 0) {
+        metrics.throughput = static_cast<double>(metrics.processed) * 1.0e9 / static_cast<double>(elapsed);
+    }
+    if (metrics.processed > 0u) {
+        metrics.avgLatency = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::nanoseconds(m_sumLatency / static_cast<int64_t>(metrics.processed)));
+    }
+    metrics.maxLatency = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::nanoseconds(m_maxLatency));
+    metrics.blocked = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::nanoseconds(m_blocked));
+    return metrics;
+}
+
+
+Pipeline::Pipeline(const CancellationToken& token)
+: m_token{token}
+{
+}
+
+Pipeline::~Pipeline()
+{
+    if (!m_waited) {
+        cancel();
+        try {
+            wait();
+        }
+        catch (...) {       // nobody is interested anymore
+        }
+    }
+}
+
+PipelineStage&
+Pipeline::start(std::unique_ptr<PipelineStage>&& stage, const std::function<void()>& work)
+{
+    auto& started = *stage;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stages.emplace_back(std::move(stage));
+    }
+    started.start([this, work] {
+        try {
+            work();
+        }
+        catch (...) {
+            failed(std::current_exception());
+        }
+    });
+    return started;
+}
+
+void
+Pipeline::failed(std::exception_ptr eptr)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (!m_eptr) {
+            m_eptr = eptr;
+        }
+    }
+    cancel();
+}
+
+void
+Pipeline::cancel()
+{
+    m_token.cancel();
+    // wake the stages waiting on a queue
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (auto& stage : m_stages) {
+        stage->close();
+    }
+}
+
+bool
+Pipeline::isCancelled() const
+{
+    return m_token.isCancelled();
+}
+
+const CancellationToken&
+Pipeline::getToken() const
+{
+    return m_token;
+}
+
+void
+Pipeline::wait()
+{
+    m_waited = true;
+    // stages are only added by the owner
+    for (auto& stage : m_stages) {
+        stage->join();
+    }
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_eptr) {
+        std::rethrow_exception(m_eptr);
+    }
+}
+
+std::vector<StageMetrics>
+Pipeline::getMetrics()
+{
+    std::vector<StageMetrics> metrics;
+    std::lock_guard<std::mutex> lock{m_mutex};
+    metrics.reserve(m_stages.size());
+    for (auto& stage : m_stages) {
+        metrics.emplace_back(stage->getMetrics());
+    }
+    return metrics;
+}
+
+} /* namespace psc::util */
@@ -0,0 +1,99 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+
+#include "PixbufFormats.hpp"
+#include "StringUtils.hpp"
+
+PixbufFormats::PixbufFormats()
+{
+    for (auto format : Gdk::Pixbuf::get_formats()) {
+        if (format.is_disabled()) {     // only include images that are displayable (readable)
+            continue;
+        }
+        for (auto mime : format.get_mime_types()) {
+            m_mimeTypes.insert(mime);
+        }
+        for (auto ext : format.get_extensions()) {
+            m_extensions.insert(Glib::ustring(ext).lowercase());
+        }
+    }
+}
+
+const PixbufFormats&
+PixbufFormats::get()
+{
+    static PixbufFormats pixbufFormats;
+    return pixbufFormats;
+}
+
+bool
+PixbufFormats::isReadableMime(const Glib::ustring& mime) const
+{
+    return m_mimeTypes.find(mime) != m_mimeTypes.end();
+}
+
+bool
+PixbufFormats::isReadableExtension(const std::string& ext) const
+{
+    return m_extensions.find(Glib::ustring(ext).lowercase()) != m_extensions.end();
+}
+
+Readable
+PixbufFormats::classify(const std::string& name, const Glib::ustring& fastContentType) const
+{
+    if (!fastContentType.empty()
+     && isReadableMime(fastContentType)) {
+        return Readable::Yes;
+    }
+    auto ext = StringUtils::getExtension(name);
+    if (!ext.empty()
+     && isReadableExtension(ext)) {
+        return Readable::Yes;
+    }
+    // guessing by name gave nothing usable e.g. no or unknown extension
+    if (fastContentType.empty()
+     || Gio::content_type_is_unknown(fastContentType)) {
+        return Readable::Unknown;
+    }
+    return Readable::No;
+}
+
+bool
+PixbufFormats::isReadable(const Glib::RefPtr<Gio::File>& file, ScanMode scanMode) const
+{
+    try {
+        if (scanMode == ScanMode::Fast) {
+            auto fi = file->query_info(FAST_SCAN_ATTRIBUTES);
+            if (fi->get_file_type() != Gio::FileType::FILE_TYPE_REGULAR) {
+                return false;
+            }
+            auto readable = classify(fi->get_name(), fi->get_attribute_string(G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE));
+            if (readable != Readable::Unknown) {
+                return readable == Readable::Yes;
+            }
+        }
+        auto fi = file->query_info(SNIFF_SCAN_ATTRIBUTES);
+        return fi->get_file_type() == Gio::FileType::FILE_TYPE_REGULAR
+            && isReadableMime(fi->get_content_type());
+    }
+    catch (const Glib::Error&) {    // e.g. removed in the meantime
+        return false;
+    }
+}
@@ -0,0 +1,138 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Task.hpp"
+
+namespace psc::util {
+
+static constexpr int ENUMERATE_BATCH{64};   // files per request
+
+void
+check_cancelled(const Glib::RefPtr<Gio::Cancellable>& cancellable)
+{
+    if (cancellable && cancellable->is_cancelled()) {
+        throw Gio::Error(Gio::Error::CANCELLED, "Operation was cancelled");
+    }
+}
+
+PoolAwaiter::PoolAwaiter(Priority priority, const Glib::RefPtr<Gio::Cancellable>& cancellable)
+: m_priority{priority}
+, m_cancellable{cancellable}
+{
+}
+
+void
+PoolAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    Executor::get().submit(m_priority, [handle] {
+        handle.resume();
+    });
+}
+
+void
+PoolAwaiter::await_resume()
+{
+    check_cancelled(m_cancellable);
+}
+
+MainAwaiter::MainAwaiter(const Glib::RefPtr<Gio::Cancellable>& cancellable)
+: m_cancellable{cancellable}
+{
+}
+
+bool
+MainAwaiter::await_ready() const
+{
+    return Glib::MainContext::get_default()->is_owner();
+}
+
+void
+MainAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    Glib::MainContext::get_default()->invoke([handle] {
+        handle.resume();
+        return false;   // once
+    });
+}
+
+void
+MainAwaiter::await_resume()
+{
+    check_cancelled(m_cancellable);
+}
+
+PoolAwaiter
+resume_on_pool(Priority priority, const Glib::RefPtr<Gio::Cancellable>& cancellable)
+{
+    return PoolAwaiter(priority, cancellable);
+}
+
+MainAwaiter
+resume_on_main(const Glib::RefPtr<Gio::Cancellable>& cancellable)
+{
+    return MainAwaiter(cancellable);
+}
+
+// the parameters are copies as they have to live in the coroutine frame
+Task<std::string>
+load_contents(Glib::RefPtr<Gio::File> file, Glib::RefPtr<Gio::Cancellable> cancellable)
+{
+    co_return co_await gio_async<std::string>(
+        [file] (const Gio::SlotAsyncReady& slot, const Glib::RefPtr<Gio::Cancellable>& cancel) {
+            file->load_contents_async(slot, cancel);
+        },
+        [file] (const Glib::RefPtr<Gio::AsyncResult>& result) {
+            char* contents{nullptr};
+            gsize length{};
+            file->load_contents_finish(result, contents, length);
+            std::string data(contents, length);
+            g_free(contents);
+            return data;
+        }, cancellable);
+}
+
+Task<std::vector<Glib::RefPtr<Gio::FileInfo>>>
+enumerate_children(Glib::RefPtr<Gio::File> dir, std::string attributes, Glib::RefPtr<Gio::Cancellable> cancellable)
+{
+    auto enumerator = co_await gio_async<Glib::RefPtr<Gio::FileEnumerator>>(
+        [dir, attributes] (const Gio::SlotAsyncReady& slot, const Glib::RefPtr<Gio::Cancellable>& cancel) {
+            dir->enumerate_children_async(slot, cancel, attributes);
+        },
+        [dir] (const Glib::RefPtr<Gio::AsyncResult>& result) {
+            return dir->enumerate_children_finish(result);
+        }, cancellable);
+    std::vector<Glib::RefPtr<Gio::FileInfo>> infos;
+    while (true) {
+        std::vector<Glib::RefPtr<Gio::FileInfo>> next = co_await gio_async<std::vector<Glib::RefPtr<Gio::FileInfo>>>(
+            [enumerator] (const Gio::SlotAsyncReady& slot, const Glib::RefPtr<Gio::Cancellable>& cancel) {
+                enumerator->next_files_async(slot, cancel, ENUMERATE_BATCH);
+            },
+            [enumerator] (const Glib::RefPtr<Gio::AsyncResult>& result) {
+                std::vector<Glib::RefPtr<Gio::FileInfo>> batch = enumerator->next_files_finish(result);
+                return batch;
+            }, cancellable);
+        if (next.empty()) {
+            break;
+        }
+        infos.insert(infos.end(), next.begin(), next.end());
+    }
+    enumerator->close();
+    co_return infos;
+}
+
+} // namespace psc::util
@@ -0,0 +1,285 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "ThumbnailService.hpp"
+#include "Log.hpp"
+
+ThumbnailService::ThumbnailService(ThumbnailSize size, uint32_t threads, size_t cacheSize, size_t maxQueued)
+: m_size{size}
+, m_cacheSize{cacheSize}
+, m_maxQueued{std::max(static_cast<size_t>(1u), maxQueued)}
+{
+    m_dispatcher.connect(sigc::mem_fun(*this, &ThumbnailService::on_done));
+    threads = std::max(1u, threads);
+    m_threads.reserve(threads);
+    for (uint32_t i = 0; i < threads; ++i) {
+        m_threads.emplace_back(std::thread(&ThumbnailService::run, this));
+    }
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_requestMutex};
+        m_active = false;
+    }
+    m_requestCond.notify_all();
+    for (auto& thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+ThumbnailSize
+ThumbnailService::getSize()
+{
+    return m_size;
+}
+
+const char*
+ThumbnailService::getSizeName(ThumbnailSize size)
+{
+    switch (size) {
+    case ThumbnailSize::Large:
+        return "large";
+    case ThumbnailSize::Normal:
+    default:
+        return "normal";
+    }
+}
+
+std::string
+ThumbnailService::getThumbnailPath(const std::string& uri, ThumbnailSize size)
+{
+    auto md5 = Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_MD5, uri);
+    return Glib::build_filename(Glib::get_user_cache_dir(), "thumbnails", getSizeName(size), md5 + ".png");
+}
+
+Glib::RefPtr<Gdk::Pixbuf>
+ThumbnailService::lookup(const Glib::RefPtr<Gio::File>& file)
+{
+    auto entry = m_lruIndex.find(file->get_uri());
+    if (entry != m_lruIndex.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, entry->second);  // mark as recently used
+        return entry->second->second;
+    }
+    return Glib::RefPtr<Gdk::Pixbuf>();
+}
+
+void
+ThumbnailService::request(const Glib::RefPtr<Gio::File>& file, const SlotThumbnail& slot)
+{
+    auto pixbuf = lookup(file);
+    if (pixbuf) {
+        slot(file, pixbuf);
+        return;
+    }
+    auto uri = file->get_uri();
+    auto pending = m_pending.find(uri);
+    if (pending != m_pending.end()) {   // already on its way, just wait for it
+        pending->second.push_back(slot);
+        return;
+    }
+    m_pending[uri].push_back(slot);
+    auto request = std::make_shared<ThumbnailRequest>();
+    request->file = file;
+    request->uri = uri;
+    std::vector<std::shared_ptr<ThumbnailRequest>> dropped;
+    {
+        std::lock_guard<std::mutex> lock{m_requestMutex};
+        m_requests.emplace_back(std::move(request));
+        while (m_requests.size() > m_maxQueued) {
+            dropped.emplace_back(std::move(m_requests.front()));
+            m_requests.pop_front();
+        }
+    }
+    m_requestCond.notify_one();
+    for (auto& stale : dropped) {   // allow requesting them again
+        m_pending.erase(stale->uri);
+    }
+}
+
+std::shared_ptr<ThumbnailRequest>
+ThumbnailService::nextRequest()
+{
+    std::unique_lock<std::mutex> lock{m_requestMutex};
+    m_requestCond.wait(lock, [this] {
+        return !m_active || !m_requests.empty();
+    });
+    if (!m_active) {
+        return std::shared_ptr<ThumbnailRequest>();
+    }
+    // newest first, these are the ones the user is looking at
+    auto request = std::move(m_requests.back());
+    m_requests.pop_back();
+    return request;
+}
+
+void
+ThumbnailService::run()
+{
+    while (true) {
+        auto request = nextRequest();
+        if (!request) {     // finished
+            break;
+        }
+        try {
+            request->pixbuf = loadThumbnail(request);
+        }
+        catch (const Glib::Error& ex) {
+            psc::log::Log::logAdd(psc::log::Level::Notice, [&] {
+                return psc::fmt::format("No thumbnail for {} {}", request->uri, ex);
+            });
+        }
+        {
+            std::lock_guard<std::mutex> lock{m_doneMutex};
+            m_done.emplace_back(std::move(request));
+        }
+        m_dispatcher.emit();
+    }
+}
+
+Glib::RefPtr<Gdk::Pixbuf>
+ThumbnailService::loadThumbnail(const std::shared_ptr<ThumbnailRequest>& request)
+{
+    auto info = request->file->query_info("time::modified,thumbnail::path,thumbnail::is-valid");
+    guint64 mtime = info->get_attribute_uint64("time::modified");
+    // gio does the lookup for us (if supported)
+    if (info->has_attribute("thumbnail::path")
+     && info->has_attribute("thumbnail::is-valid")
+     && info->get_attribute_boolean("thumbnail::is-valid")) {
+        auto pixbuf = Gdk::Pixbuf::create_from_file(info->get_attribute_byte_string("thumbnail::path"));
+        if (pixbuf) {
+            return pixbuf;
+        }
+    }
+    auto path = getThumbnailPath(request->uri, m_size);
+    auto pixbuf = readValid(path, request->uri, mtime);
+    if (!pixbuf) {
+        pixbuf = createThumbnail(request, mtime);
+    }
+    return pixbuf;
+}
+
+Glib::RefPtr<Gdk::Pixbuf>
+ThumbnailService::readValid(const std::string& path, const std::string& uri, guint64 mtime)
+{
+    if (Glib::file_test(path, Glib::FileTest::FILE_TEST_IS_REGULAR)) {
+        try {
+            auto pixbuf = Gdk::Pixbuf::create_from_file(path);
+            if (pixbuf->get_option("tEXt::Thumb::URI") == uri
+             && pixbuf->get_option("tEXt::Thumb::MTime") == std::to_string(mtime)) {
+                return pixbuf;
+            }
+        }
+        catch (const Glib::Error& ex) {     // damaged, recreate
+            psc::log::Log::logAdd(psc::log::Level::Notice, [&] {
+                return psc::fmt::format("Thumbnail {} unreadable {}", path, ex);
+            });
+        }
+    }
+    return Glib::RefPtr<Gdk::Pixbuf>();
+}
+
+Glib::RefPtr<Gdk::Pixbuf>
+ThumbnailService::createThumbnail(const std::shared_ptr<ThumbnailRequest>& request, guint64 mtime)
+{
+    const int px = static_cast<int>(m_size);
+    // the spec says not to scale up images that are smaller than the thumbnail
+    int width{0}, height{0};
+    auto filePath = request->file->get_path();
+    if (!filePath.empty()) {
+        Gdk::Pixbuf::get_file_info(filePath, width, height);     // just reads the header
+    }
+    bool isSmall = width > 0 && height > 0
+                && width <= px && height <= px;
+    // decode at scale, this avoids the full size image (for some formats e.g. jpeg)
+    auto stream = request->file->read();
+    auto scaled = isSmall
+                ? Gdk::Pixbuf::create_from_stream(stream)
+                : Gdk::Pixbuf::create_from_stream_at_scale(stream, px, px, true);
+    stream->close();
+    auto pixbuf = scaled->apply_embedded_orientation();
+    auto path = getThumbnailPath(request->uri, m_size);
+    auto dir = Glib::path_get_dirname(path);
+    if (g_mkdir_with_parents(dir.c_str(), 0700) != 0) {
+        psc::log::Log::logAdd(psc::log::Level::Notice, "Unable to create " + dir);
+        return pixbuf;      // use it anyway
+    }
+    std::vector<Glib::ustring> keys{"tEXt::Thumb::URI", "tEXt::Thumb::MTime", "tEXt::Software"};
+    std::vector<Glib::ustring> values{request->uri, std::to_string(mtime), "genericimg"};
+    // write in a unique temporary file, and make it visible atomically as the spec suggests
+    std::ostringstream tmp;
+    tmp << path << '.' << std::this_thread::get_id() << ".tmp";
+    try {
+        pixbuf->save(tmp.str(), "png", keys, values);
+        g_chmod(tmp.str().c_str(), S_IRUSR | S_IWUSR);
+        if (g_rename(tmp.str().c_str(), path.c_str()) != 0) {
+            g_remove(tmp.str().c_str());
+        }
+    }
+    catch (const Glib::Error& ex) {
+        g_remove(tmp.str().c_str());
+        psc::log::Log::logAdd(psc::log::Level::Notice, [&] {
+            return psc::fmt::format("Thumbnail {} not saved {}", path, ex);
+        });
+    }
+    return pixbuf;
+}
+
+void
+ThumbnailService::cache(const std::string& uri, const Glib::RefPtr<Gdk::Pixbuf>& pixbuf)
+{
+    m_lru.emplace_front(uri, pixbuf);
+    m_lruIndex[uri] = m_lru.begin();
+    while (m_lru.size() > m_cacheSize) {
+        m_lruIndex.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+}
+
+void
+ThumbnailService::on_done()
+{
+    std::vector<std::shared_ptr<ThumbnailRequest>> done;
+    {
+        std::lock_guard<std::mutex> lock{m_doneMutex};
+        done.swap(m_done);
+    }
+    for (auto& request : done) {
+        if (request->pixbuf) {
+            cache(request->uri, request->pixbuf);
+        }
+        auto pending = m_pending.find(request->uri);
+        if (pending != m_pending.end()) {
+            auto slots = std::move(pending->second);
+            m_pending.erase(pending);
+            for (auto& slot : slots) {
+                slot(request->file, request->pixbuf);
+            }
+        }
+    }
+}
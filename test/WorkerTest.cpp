@@ -23,10 +23,32 @@
 
 #include "WorkerTest.hpp"
 #include "KeyConfig.hpp"
+#include "Task.hpp"
 
 using namespace std::chrono_literals; // ns, us, ms, s, h, etc.
 
 
+static constexpr auto COROUTINE_CONTENT{"coroutine content"};
+
+// switch threads and read a file in sequence
+static psc::util::Task<bool>
+coroutineTest(Glib::RefPtr<Gio::File> file)
+{
+    auto mainThread = std::this_thread::get_id();
+    co_await psc::util::resume_on_pool();
+    bool onPool = std::this_thread::get_id() != mainThread;
+    co_await psc::util::resume_on_main();
+    bool onMain = std::this_thread::get_id() == mainThread;
+    auto contents = co_await psc::util::load_contents(file);
+    if (!onPool || !onMain || contents != COROUTINE_CONTENT) {
+        std::cout << "Coroutine pool " << std::boolalpha << onPool
+                  << " main " << onMain
+                  << " content " << contents << std::endl;
+        co_return false;
+    }
+    co_return true;
+}
+
 TestApp::TestApp()
 : Gio::Application("de.pfeifer_syscon.workerTest")
 {
@@ -39,6 +61,51 @@ TestApp::start()
     m_workerStart->execute();
     m_workerExcept = std::make_shared<WorkerExcept>();
     m_workerExcept->execute();
+    startQuick();
+    m_workerRing = std::make_shared<WorkerRing>();
+    m_workerRing->execute();
+    {   // destroyed on the gtk thread while the producer waits for room, this must not block
+        auto abandoned = std::make_shared<WorkerRing>();
+        abandoned->execute();
+        std::this_thread::sleep_for(50ms);      // let it fill the queue
+    }
+    m_ringDestroyed = true;
+    m_workerCancel = std::make_shared<WorkerCancel>();
+    m_workerCancel->execute();
+    Glib::signal_timeout().connect_once([this] {
+        m_workerCancel->cancel();
+    }, std::chrono::duration_cast<std::chrono::milliseconds>(WorkerCancel::RUN_TIME).count());
+    auto path = Glib::build_filename(Glib::get_tmp_dir(), "coroutine_test.txt");
+    Glib::file_set_contents(path, COROUTINE_CONTENT);
+    psc::util::spawn(coroutineTest(Gio::File::create_for_path(path))
+        , [this] (bool result) {
+            m_coroutine = result;
+        }
+        , [] (std::exception_ptr eptr) {
+            try {
+                std::rethrow_exception(eptr);
+            }
+            catch (const Glib::Error& exc) {
+                std::cout << "Coroutine exc " << exc.what() << std::endl;
+            }
+            catch (const std::exception& exc) {
+                std::cout << "Coroutine exc " << exc.what() << std::endl;
+            }
+        });
+}
+
+void
+TestApp::startQuick()
+{
+    if (m_workerQuick.size() >= QUICK_COUNT) {
+        m_quickCompleted = true;
+        return;
+    }
+    // keep the previous workers, as we are called from done
+    auto worker = std::make_shared<WorkerQuick>(
+            sigc::mem_fun(*this, &TestApp::startQuick));
+    m_workerQuick.push_back(worker);
+    worker->execute(psc::util::Priority::Background);    // short, so use the shared executor
 }
 
 void
@@ -93,6 +160,51 @@ TestApp::getResult()
         std::cout << "Except expected true got " << std::boolalpha << m_workerExcept->m_error << std::endl;
         return 3;
     }
+    if (m_workerQuick.size() != QUICK_COUNT
+     || !m_quickCompleted) {
+        std::cout << "Quick expected " << QUICK_COUNT << " workers got " << m_workerQuick.size() << std::endl;
+        return 6;
+    }
+    for (auto& worker : m_workerQuick) {
+        if (worker->m_processed != WorkerStart::INTERM_VAL) {
+            std::cout << "Quick expected processed " << WorkerStart::INTERM_VAL << " got " << worker->m_processed << std::endl;
+            return 7;
+        }
+    }
+    // each worker notifies right before the end, the handshake has to deliver it before done
+    for (auto& worker : m_workerQuick) {
+        if (worker->m_processedAtDone != WorkerStart::INTERM_VAL) {
+            std::cout << "Quick expected processed before done " << WorkerStart::INTERM_VAL
+                      << " got " << worker->m_processedAtDone << std::endl;
+            return 8;
+        }
+    }
+    if (!m_workerRing->m_done
+     || m_workerRing->m_next != WorkerRing::COUNT
+     || !m_workerRing->m_ordered) {
+        std::cout << "Ring expected " << WorkerRing::COUNT << " ordered values got " << m_workerRing->m_next
+                  << " ordered " << std::boolalpha << m_workerRing->m_ordered << std::endl;
+        return 10;
+    }
+    if (!m_ringDestroyed) {
+        std::cout << "Ring expected the destruction to return" << std::endl;
+        return 13;
+    }
+    if (!m_coroutine) {
+        std::cout << "Coroutine expected to succeed" << std::endl;
+        return 11;
+    }
+    // the progress is reported each ms, but shown with the rate only
+    auto maxProgress = std::chrono::duration_cast<std::chrono::milliseconds>(WorkerCancel::RUN_TIME).count()
+                     * WorkerCancel::DEFAULT_PROGRESS_RATE / 1000 + 2;
+    if (!m_workerCancel->m_done
+     || !m_workerCancel->m_cancelled
+     || m_workerCancel->m_progressCalls == 0
+     || m_workerCancel->m_progressCalls > maxProgress) {
+        std::cout << "Cancel expected cancelled " << std::boolalpha << m_workerCancel->m_cancelled
+                  << " progress calls " << m_workerCancel->m_progressCalls << " max " << maxProgress << std::endl;
+        return 12;
+    }
     // Simply add the config test
     KeyConfig conf = KeyConfig("testing.conf");
     Gdk::RGBA color{"rgb(192,128,192)"};
@@ -159,6 +271,109 @@ WorkerExcept::done()
     }
 }
 
+WorkerQuick::WorkerQuick(const std::function<void()>& next)
+: m_next{next}
+{
+}
+
+long
+WorkerQuick::doInBackground()
+{
+    notify(WorkerStart::INTERM_VAL);
+    return WorkerStart::FINAL_VAL;
+}
+
+void
+WorkerQuick::process(const std::vector<int>& out)
+{
+    for (auto val : out) {
+        m_processed += val;
+    }
+}
+
+void
+WorkerQuick::done()
+{
+    try {
+        getResult();
+    }
+    catch (const std::exception& exc) {
+        std::cout << "WorkerQuick::done exc " << exc.what() << std::endl;
+    }
+    m_processedAtDone = m_processed;
+    m_next();
+}
+
+long
+WorkerRing::doInBackground()
+{
+    for (int i = 0; i < COUNT; ++i) {
+        notify(i);
+    }
+    return COUNT;
+}
+
+void
+WorkerRing::process(const std::vector<int>& out)
+{
+    for (auto val : out) {
+        if (val != m_next) {
+            m_ordered = false;
+        }
+        ++m_next;
+    }
+}
+
+void
+WorkerRing::done()
+{
+    try {
+        m_done = getResult() == COUNT;
+    }
+    catch (const std::exception& exc) {
+        std::cout << "WorkerRing::done exc " << exc.what() << std::endl;
+    }
+}
+
+long
+WorkerCancel::doInBackground()
+{
+    long steps{};
+    while (!isCancelled()) {
+        std::this_thread::sleep_for(1ms);
+        ++steps;
+        progress(static_cast<double>(steps % 1000) / 1000.0);
+    }
+    getToken().throwIfCancelled();
+    return steps;
+}
+
+void
+WorkerCancel::process(const std::vector<int>& out)
+{
+}
+
+void
+WorkerCancel::onProgress(double progress)
+{
+    ++m_progressCalls;
+}
+
+void
+WorkerCancel::done()
+{
+    try {
+        getResult();
+    }
+    catch (const psc::util::CancelledException& exc) {
+        m_cancelled = true;
+    }
+    catch (const std::exception& exc) {
+        std::cout << "WorkerCancel::done exc " << exc.what() << std::endl;
+    }
+    m_done = true;
+}
+
 int main(int argc, char** argv)
 {
     std::setlocale(LC_ALL, "");      // make locale dependent, and make glib accept u8 const !!!
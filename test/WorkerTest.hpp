@@ -21,9 +21,14 @@
 #include <glibmm.h>
 #include <giomm.h>
 #include <memory>
+#include <vector>
+#include <chrono>
+#include <functional>
 
 #include "ThreadWorker.hpp"
 
+using namespace std::chrono_literals;
+
 
 class WorkerStart
 : public ThreadWorker<int, long>
@@ -56,6 +61,64 @@ public:
     bool m_error{false};
 };
 
+// short worker, to check the completion is not delayed
+class WorkerQuick
+: public ThreadWorker<int, long>
+{
+public:
+    WorkerQuick(const std::function<void()>& next);
+    explicit WorkerQuick(const WorkerQuick& orig) = delete;
+    virtual ~WorkerQuick() = default;
+
+    long doInBackground() override;
+    void process(const std::vector<int>& out) override;
+    void done() override;
+
+    int m_processed{};
+    int m_processedAtDone{};
+private:
+    std::function<void()> m_next;
+};
+
+// many notifies thru the lock free queue, with a size that requires waiting
+class WorkerRing
+: public ThreadWorker<int, long, RingQueue<int, 64u>>
+{
+public:
+    WorkerRing() = default;
+    explicit WorkerRing(const WorkerRing& orig) = delete;
+    virtual ~WorkerRing() = default;
+
+    long doInBackground() override;
+    void process(const std::vector<int>& out) override;
+    void done() override;
+
+    static constexpr int COUNT{10000};
+    int m_next{};
+    bool m_ordered{true};
+    bool m_done{false};
+};
+
+// runs until cancelled, with progress faster than the rate
+class WorkerCancel
+: public ThreadWorker<int, long>
+{
+public:
+    WorkerCancel() = default;
+    explicit WorkerCancel(const WorkerCancel& orig) = delete;
+    virtual ~WorkerCancel() = default;
+
+    long doInBackground() override;
+    void process(const std::vector<int>& out) override;
+    void done() override;
+    void onProgress(double progress) override;
+
+    static constexpr auto RUN_TIME{300ms};
+    uint32_t m_progressCalls{};
+    bool m_cancelled{false};
+    bool m_done{false};
+};
+
 class TestApp
 : public Gio::Application
 {
@@ -68,10 +131,18 @@ public:
     int getResult();
 protected:
     void start();
+    void startQuick();
 
 private:
     std::shared_ptr<WorkerStart> m_workerStart;
     std::shared_ptr<WorkerExcept> m_workerExcept;
+    std::vector<std::shared_ptr<WorkerQuick>> m_workerQuick;
+    std::shared_ptr<WorkerRing> m_workerRing;
+    std::shared_ptr<WorkerCancel> m_workerCancel;
+    bool m_coroutine{false};
+    bool m_quickCompleted{false};
+    bool m_ringDestroyed{false};
+    static constexpr auto QUICK_COUNT{10u};
 };
 
 
@@ -21,15 +21,26 @@
 #include <fstream>
 #include <format>
 #include <memory>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <filesystem>
+#include <atomic>
 
 #include "genericimg_config.h"
 #include "Log.hpp"
+#include "LogImpl.hpp"
 #include "LogView.hpp"
 #include "LogViewFile.hpp"
 #include "LogViewSysd.hpp"
 #include "LogViewSyslog.hpp"
+#include "LogViewBinary.hpp"
 #include "DateUtils.hpp"
 
+using namespace std::chrono_literals;
+
 static bool
 test_log()
 {
@@ -73,6 +84,532 @@ test_log()
     return true;
 }
 
+static bool
+test_log_async()
+{
+    const std::string logFile{"async.log"};
+    std::remove(logFile.c_str());
+    auto filePlug = std::make_shared<psc::log::FilePlugin>("async");
+    filePlug->setSizeLimit(std::numeric_limits<goffset>::max());  // no rotation, count all lines
+    filePlug->createLogFile(Gio::File::create_for_path(logFile));
+    psc::log::Log log(std::make_shared<psc::log::AsyncPlugin>(filePlug));
+    log.setRateLimit(0u);   // count all lines
+    constexpr uint32_t THREADS{4u};
+    constexpr uint32_t COUNT{1000u};
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&log, t] {
+            for (uint32_t i = 0; i < COUNT; ++i) {
+                log.info(std::format("thread {} msg {}", t, i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    log.close();    // has to write all queued
+    auto fs = std::ifstream(logFile);
+    uint32_t lines{};
+    std::string line;
+    while (std::getline(fs, line)) {
+        ++lines;
+    }
+    std::remove(logFile.c_str());
+    if (lines != THREADS * COUNT) {
+        std::cout << "Log async expected " << THREADS * COUNT << " lines got " << lines << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// the lines written concurrently shall not interleave
+static bool
+test_log_threads()
+{
+    const std::string logFile{"threads.log"};
+    std::remove(logFile.c_str());
+    auto filePlug = std::make_shared<psc::log::FilePlugin>("threads");
+    filePlug->setSizeLimit(std::numeric_limits<goffset>::max());  // no rotation, count all lines
+    filePlug->createLogFile(Gio::File::create_for_path(logFile));
+    psc::log::Log log(filePlug);
+    log.setRateLimit(0u);
+    constexpr uint32_t THREADS{4u};
+    constexpr uint32_t COUNT{1000u};
+    std::vector<std::thread> threads;
+    std::vector<uint32_t> threadIds(THREADS);
+    for (uint32_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&log, &threadIds, t] {
+            threadIds[t] = psc::log::Log::getThreadId();
+            for (uint32_t i = 0; i < COUNT; ++i) {
+                log.info(std::format("thread {} msg {} end", t, i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    log.close();
+    auto fs = std::ifstream(logFile);
+    uint32_t lines{};
+    std::string line;
+    while (std::getline(fs, line)) {
+        if (line.find("thread ") == line.npos
+         || !line.ends_with(" end")) {
+            std::cout << "Log threads mixed line " << line << std::endl;
+            return false;
+        }
+        ++lines;
+    }
+    std::remove(logFile.c_str());
+    std::sort(threadIds.begin(), threadIds.end());
+    if (lines != THREADS * COUNT
+     || std::adjacent_find(threadIds.begin(), threadIds.end()) != threadIds.end()) {
+        std::cout << "Log threads expected " << THREADS * COUNT << " lines got " << lines << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// the arguments have to be copied, as the formatting is done later
+static bool
+test_log_deferred()
+{
+    const std::string logFile{"deferred.log"};
+    std::remove(logFile.c_str());
+    auto filePlug = std::make_shared<psc::log::FilePlugin>("deferred");
+    filePlug->createLogFile(Gio::File::create_for_path(logFile));
+    psc::log::Log log(std::make_shared<psc::log::AsyncPlugin>(filePlug));
+    char buf[16] = "original";
+    log.log(psc::log::Level::Info, "deferred {} {} {}", 42, buf, Glib::ustring("ustring"));
+    buf[0] = 'X';
+    log.log(psc::log::Level::Debug, "not logged {}", 1);
+    log.debug("not logged {}", 2);
+    log.log<psc::log::Level::Error>("compiled {}", 3);
+    log.close();
+    auto fs = std::ifstream(logFile);
+    std::string line;
+    std::getline(fs, line);
+    std::string line2;
+    std::getline(fs, line2);
+    std::remove(logFile.c_str());
+    if (!psc::log::isCompiled(psc::log::Level::Info)) {
+        return line.find("deferred") == line.npos;  // removed by -Dlog_level
+    }
+    if (!line.ends_with("deferred 42 original ustring")
+     || !line2.ends_with("compiled 3")) {
+        std::cout << "Log deferred got " << line << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// keeps the configured generations, the older ones compressed and readable by LogViewFile
+static bool
+test_log_rotate()
+{
+    const std::string logFile{"rotate.log"};
+    auto filePlug = std::make_shared<psc::log::FilePlugin>("rotate");
+    filePlug->setSizeLimit(1024);
+    filePlug->setGenerations(3u);
+    filePlug->createLogFile(Gio::File::create_for_path(logFile));
+    for (uint32_t i = 0; i < 200u; ++i) {
+        filePlug->log(psc::log::Level::Info, std::format("rotate msg {}", i), std::source_location::current());
+    }
+    filePlug->close();      // waits for the compression
+    std::vector<std::string> expected{logFile, logFile + ".1", logFile + ".2.gz", logFile + ".3.gz"};
+    std::vector<std::string> removed{logFile + ".2", logFile + ".4.gz"};
+    bool ok = true;
+    for (auto& name : expected) {
+        if (!std::filesystem::exists(name)
+         || !psc::log::LogViewFile::isLogFile(name)) {
+            std::cout << "Log rotate missing " << name << std::endl;
+            ok = false;
+        }
+    }
+    for (auto& name : removed) {
+        if (std::filesystem::exists(name)) {
+            std::cout << "Log rotate unexpected " << name << std::endl;
+            ok = false;
+        }
+    }
+    auto compressed = logFile + ".2.gz";
+    auto cnt = 0u;
+    if (ok) {
+        auto logViewFile = psc::log::LogViewFile::create();
+        std::map<psc::log::LogDays, uint64_t> mapDays;
+        auto logViewId = std::make_shared<psc::log::LogViewIdFile>(psc::log::LogViewType::Name, ".", mapDays
+                                    , std::filesystem::file_size(compressed), compressed);
+        std::list<psc::log::pLogViewIdentifier> query;
+        query.emplace_back(std::move(logViewId));
+        logViewFile->setQuery(query);
+        for (auto iter = logViewFile->begin(); iter != logViewFile->end(); ++iter) {
+            auto entry = *iter;
+            if (entry.getMessage().find("rotate msg ") == std::string::npos) {
+                std::cout << "Log rotate unexpected " << entry.getMessage() << std::endl;
+                ok = false;
+            }
+            ++cnt;
+        }
+    }
+    for (auto& name : expected) {
+        std::remove(name.c_str());
+    }
+    if (cnt == 0u) {
+        std::cout << "Log rotate no entries in " << compressed << std::endl;
+        return false;
+    }
+    return ok;
+}
+
+// a failing rotation shall not throw, the lines are appended to the current file
+static bool
+test_log_rotate_fail()
+{
+    const std::string logFile{"rotate_fail.log"};
+    const std::string blocking{logFile + ".1"};
+    std::filesystem::create_directories(blocking + "/keep");     // a directory can't be replaced by the move
+    auto filePlug = std::make_shared<psc::log::FilePlugin>("rotate_fail");
+    filePlug->setSizeLimit(1024);
+    filePlug->setGenerations(1u);
+    filePlug->createLogFile(Gio::File::create_for_path(logFile));
+    const uint32_t COUNT{100u};
+    bool ok = true;
+    try {
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            filePlug->log(psc::log::Level::Info, std::format("rotate fail msg {}", i), std::source_location::current());
+        }
+    }
+    catch (const Glib::Error& ex) {
+        std::cout << "Log rotate fail threw " << ex.what() << std::endl;
+        ok = false;
+    }
+    filePlug->close();
+    std::ifstream stream{logFile};
+    std::string line;
+    auto cnt = 0u;
+    while (std::getline(stream, line)) {
+        if (line.find("rotate fail msg ") != std::string::npos) {
+            ++cnt;
+        }
+    }
+    stream.close();
+    std::remove(logFile.c_str());
+    std::filesystem::remove_all(blocking);
+    if (cnt != COUNT) {
+        std::cout << "Log rotate fail got " << cnt << " lines expected " << COUNT << std::endl;
+        return false;
+    }
+    return ok;
+}
+
+// the records shall be read back as written
+static bool
+test_log_binary()
+{
+    const std::string logFile{"binary.blog"};
+    std::remove(logFile.c_str());
+    auto binaryPlug = std::make_shared<psc::log::BinaryPlugin>("binary");
+    binaryPlug->createLogFile(Gio::File::create_for_path(logFile));
+    std::vector<std::string> messages;
+    for (uint32_t i = 0; i < 3u; ++i) {
+        messages.emplace_back(std::format("binary msg {} äöü", i));
+        binaryPlug->log(psc::log::Level::Warn, messages.back(), std::source_location::current());
+    }
+    messages.emplace_back("other location");
+    binaryPlug->log(psc::log::Level::Error, messages.back(), std::source_location::current());
+    binaryPlug->close();
+    {   // a damaged record shall end the iteration, not allocate what it claims
+        psc::log::BinaryRecordHeader header{};
+        header.length = std::numeric_limits<uint32_t>::max();
+        header.type = psc::log::BinaryRecordType::Entry;
+        std::ofstream damaged{logFile, std::ios::binary | std::ios::app};
+        damaged.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    auto logViewBinary = psc::log::LogViewBinary::create();
+    std::map<psc::log::LogDays, uint64_t> mapDays;
+    auto logViewId = std::make_shared<psc::log::LogViewIdFile>(psc::log::LogViewType::Name, ".", mapDays
+                                , std::filesystem::file_size(logFile), logFile);
+    std::list<psc::log::pLogViewIdentifier> query;
+    query.emplace_back(std::move(logViewId));
+    logViewBinary->setQuery(query);
+    std::vector<psc::log::LogViewEntry> entries;
+    for (auto iter = logViewBinary->begin(); iter != logViewBinary->end(); ++iter) {
+        entries.emplace_back(*iter);
+    }
+    std::remove(logFile.c_str());
+    if (entries.size() != messages.size()) {
+        std::cout << "Log binary expected " << messages.size() << " entries got " << entries.size() << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto expLevel = i < 3u ? psc::log::Level::Warn : psc::log::Level::Error;
+        if (entries[i].getMessage() != messages[i]
+         || entries[i].getLevel() != expLevel
+         || entries[i].getLocation().find("log_test.cpp:") == std::string::npos
+         || !entries[i].getLocalTime().isValid()) {
+            std::cout << "Log binary unexpected " << entries[i].getMessage()
+                      << " location " << entries[i].getLocation() << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// a flooding call site is limited, the suppressed messages are counted
+static bool
+test_log_rate()
+{
+    if (!psc::log::isCompiled(psc::log::Level::Warn)) {
+        return true;
+    }
+    const std::string logFile{"rate.log"};
+    std::remove(logFile.c_str());
+    auto filePlug = std::make_shared<psc::log::FilePlugin>("rate");
+    filePlug->createLogFile(Gio::File::create_for_path(logFile));
+    psc::log::Log log(filePlug);
+    constexpr uint32_t BURST{5u};
+    constexpr uint32_t COUNT{100u};
+    log.setRateLimit(BURST, 1.0);
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        log.log(psc::log::Level::Warn, "rate {}", i);
+    }
+    log.log(psc::log::Level::Crit, "not limited");
+    log.close();        // reports the remaining
+    auto fs = std::ifstream(logFile);
+    uint32_t logged{};
+    uint32_t suppressed{};
+    std::string line;
+    while (std::getline(fs, line)) {
+        auto pos = line.find(" similar messages suppressed");
+        if (pos != line.npos) {
+            auto start = line.rfind(' ', pos - 1u) + 1u;
+            suppressed += static_cast<uint32_t>(std::stoul(line.substr(start, pos - start)));
+        }
+        else if (line.find("rate ") != line.npos) {
+            ++logged;
+        }
+    }
+    std::remove(logFile.c_str());
+    if (logged < BURST
+     || logged > BURST + 1u         // one token may have been refilled
+     || logged + suppressed != COUNT) {
+        std::cout << "Log rate logged " << logged << " suppressed " << suppressed << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// the suppressed count of a site that went quiet is reported with the next passing message
+static bool
+test_log_rate_report()
+{
+    if (!psc::log::isCompiled(psc::log::Level::Warn)) {
+        return true;
+    }
+    const std::string logFile{"rate_report.log"};
+    std::remove(logFile.c_str());
+    auto filePlug = std::make_shared<psc::log::FilePlugin>("rate_report");
+    filePlug->createLogFile(Gio::File::create_for_path(logFile));
+    psc::log::Log log(filePlug);
+    constexpr uint32_t BURST{2u};
+    constexpr uint32_t COUNT{10u};
+    log.setRateLimit(BURST, 0.001, std::chrono::seconds(0));    // report with any message
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        log.log(psc::log::Level::Warn, "flood {}", i);
+    }
+    log.log(psc::log::Level::Warn, "other site");
+    auto fs = std::ifstream(logFile);       // the file plugin has written, check before close
+    uint32_t suppressed{};
+    std::string line;
+    while (std::getline(fs, line)) {
+        auto pos = line.find(" similar messages suppressed");
+        if (pos != line.npos) {
+            auto start = line.rfind(' ', pos - 1u) + 1u;
+            suppressed += static_cast<uint32_t>(std::stoul(line.substr(start, pos - start)));
+        }
+    }
+    fs.close();
+    log.close();
+    std::remove(logFile.c_str());
+    if (suppressed != COUNT - BURST) {
+        std::cout << "Log rate report suppressed " << suppressed << " expected " << COUNT - BURST << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// each sink gets the records for its level and filter, the text sinks the same lines
+static bool
+test_log_fanout()
+{
+    if (!psc::log::isCompiled(psc::log::Level::Notice)) {
+        return true;
+    }
+    const std::string logFile{"fanout.log"};
+    std::remove(logFile.c_str());
+    auto filePlug = std::make_shared<psc::log::FilePlugin>("fanout");
+    filePlug->createLogFile(Gio::File::create_for_path(logFile));
+    auto ring = std::make_shared<psc::log::RingPlugin>();
+    auto keepRing = std::make_shared<psc::log::RingPlugin>();
+    auto fanout = std::make_shared<psc::log::FanoutPlugin>();
+    auto ringSink = fanout->addSink(ring, psc::log::Level::Debug);
+    fanout->addSink(filePlug, psc::log::Level::Warn);
+    auto keepSink = fanout->addSink(keepRing, psc::log::Level::Debug, [] (const psc::log::LogRecord& record) {
+        return record.msg.find("keep") != Glib::ustring::npos;
+    });
+    psc::log::Log log(std::make_shared<psc::log::AsyncPlugin>(fanout));
+    if (!log.isLoggable(psc::log::Level::Debug)) {      // the level is taken from the sinks
+        std::cout << "Log fanout expected debug to pass" << std::endl;
+        return false;
+    }
+    fanout->setSinkLevel(ringSink, psc::log::Level::Notice);
+    fanout->setSinkLevel(keepSink, psc::log::Level::Notice);
+    if (log.isLoggable(psc::log::Level::Info)
+     || !log.isLoggable(psc::log::Level::Notice)) {
+        std::cout << "Log fanout expected the sinks level notice" << std::endl;
+        return false;
+    }
+    log.log(psc::log::Level::Notice, "notice {}", 1);
+    log.log(psc::log::Level::Warn, "warn {}", "keep");
+    log.close();
+    auto fs = std::ifstream(logFile);
+    std::vector<std::string> fileLines;
+    std::string line;
+    while (std::getline(fs, line)) {
+        fileLines.push_back(line);
+    }
+    std::remove(logFile.c_str());
+    auto ringLines = ring->getLines();
+    auto keepLines = keepRing->getLines();
+    if (ringLines.size() != 2u
+     || !ringLines[0].ends_with("notice 1")
+     || fileLines.size() != 1u
+     || fileLines[0] != ringLines[1]
+     || keepLines.size() != 1u
+     || !keepLines[0].ends_with("warn keep")) {
+        std::cout << "Log fanout ring " << ringLines.size()
+                  << " file " << fileLines.size()
+                  << " keep " << keepLines.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// counts the records, to check when they were written
+class CountPlugin
+: public psc::log::LogPlugin
+{
+public:
+    CountPlugin()
+    : psc::log::LogPlugin("count")
+    {
+    }
+    void log(psc::log::Level level
+            , const Glib::ustring& msg
+            , const std::source_location location) override
+    {
+        ++m_count;
+    }
+    void write(const psc::log::LogRecord& record) override
+    {
+        if (record.level == psc::log::Level::Crit) {
+            ++m_crit;
+        }
+        ++m_count;
+    }
+    std::atomic<uint32_t> m_count{0u};
+    std::atomic<uint32_t> m_crit{0u};
+};
+
+// a crit record is written before log returns, even if others are logging and close follows,
+//   and close loses nothing logged before or while closing
+static bool
+test_log_close()
+{
+    if (!psc::log::isCompiled(psc::log::Level::Info)) {
+        return true;
+    }
+    auto count = std::make_shared<CountPlugin>();
+    psc::log::Log log(std::make_shared<psc::log::AsyncPlugin>(count));
+    log.setRateLimit(0u);
+    constexpr uint32_t THREADS{4u};
+    constexpr uint32_t COUNT{5000u};    // more than the queue takes
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&log, t] {
+            for (uint32_t i = 0; i < COUNT; ++i) {
+                log.info(std::format("thread {} msg {}", t, i));
+            }
+        });
+    }
+    bool critWritten{false};
+    std::thread closer([&] {
+        std::this_thread::sleep_for(1ms);     // let the others fill the queue
+        log.log(psc::log::Level::Crit, "crit {}", 1);
+        critWritten = count->m_crit.load() == 1u;
+        log.close();
+    });
+    closer.join();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (!critWritten
+     || count->m_count.load() != THREADS * COUNT + 1u) {
+        std::cout << "Log close crit written " << std::boolalpha << critWritten
+                  << " expected " << THREADS * COUNT + 1u << " got " << count->m_count.load() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// the file lines include the thread, the reader accepts lines with and without
+static bool
+test_log_thread()
+{
+    psc::log::LogRecord record{psc::log::Level::Warn, "thread msg", std::source_location::current()
+                             , std::chrono::system_clock::now(), 7u};
+    std::string out;
+    psc::log::FilePlugin::format(record, out);
+    auto logViewFile = psc::log::LogViewFile::create();
+    auto line = out.substr(0, out.find('\n'));
+    auto withThread = logViewFile->parse(line);
+    auto threadPos = line.find(" [7] ");
+    if (threadPos == line.npos) {
+        std::cout << "Log thread missing in " << line << std::endl;
+        return false;
+    }
+    auto withoutThread = logViewFile->parse(line.erase(threadPos, 4u));  // as written before
+    if (withThread.getMessage().find("thread msg") == std::string::npos
+     || withThread.getLevel() != psc::log::Level::Warn
+     || withThread.getMessage() != withoutThread.getMessage()
+     || withoutThread.getLevel() != psc::log::Level::Warn) {
+        std::cout << "Log thread got " << out
+                  << " parsed " << withThread.getMessage() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// the cached timestamp has to match the glib formatting
+static bool
+test_timestamp()
+{
+    auto now = std::chrono::system_clock::now();
+    for (auto offset : {0ms, 7ms, 1s, 1003ms, 24h}) {
+        auto time = now + offset;
+        auto secs = std::chrono::floor<std::chrono::seconds>(time);
+        auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(time - secs).count();
+        auto dateTime = Glib::DateTime::create_now_local(static_cast<gint64>(secs.time_since_epoch().count()));
+        std::string expected = dateTime.format("%F %T") + std::format(".{:03d}", millis);
+        auto formatted = psc::log::TimestampFormat::format(time);
+        if (formatted != expected) {
+            std::cout << "Timestamp expected " << expected << " got " << formatted << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 static bool
 parse_test()
 {
@@ -232,6 +769,42 @@ int main(int argc, char** argv)
     if (!parse_test()) {
         return 5;
     }
+    if (!test_log_async()) {
+        return 6;
+    }
+    if (!test_log_threads()) {
+        return 7;
+    }
+    if (!test_timestamp()) {
+        return 8;
+    }
+    if (!test_log_deferred()) {
+        return 9;
+    }
+    if (!test_log_rotate()) {
+        return 10;
+    }
+    if (!test_log_binary()) {
+        return 11;
+    }
+    if (!test_log_rate()) {
+        return 12;
+    }
+    if (!test_log_rate_report()) {
+        return 13;
+    }
+    if (!test_log_fanout()) {
+        return 14;
+    }
+    if (!test_log_close()) {
+        return 15;
+    }
+    if (!test_log_thread()) {
+        return 16;
+    }
+    if (!test_log_rotate_fail()) {
+        return 17;
+    }
 
 
     return 0;
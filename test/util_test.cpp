@@ -17,11 +17,23 @@
  */
 
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <unistd.h>
 #include <StringUtils.hpp>
 
 #include "KeyConfig.hpp"
 #include "BinModel.hpp"
 #include "DateUtils.hpp"
+#include "Mode.hpp"
+#include "Executor.hpp"
+#include "Parallel.hpp"
+#include "ConcurrentCollections.hpp"
+#include "Pipeline.hpp"
+#include "ThumbnailService.hpp"
+#include "NavigationList.hpp"
+#include "PixbufFormats.hpp"
+#include "ImageList.hpp"
 
 
 static bool
@@ -87,6 +99,723 @@ date_test()
     return true;
 }
 
+static bool
+paging_test()
+{
+    std::vector<Glib::RefPtr<Gio::File>> picts;
+    for (auto name : {"a.jpg", "c.jpg", "e.jpg"}) {
+        picts.push_back(Gio::File::create_for_path(Glib::build_filename("/tmp", name)));
+    }
+    PagingMode paging{1, picts};    // front c.jpg
+    auto front = [&] {
+        return paging.getPicts()[paging.get()]->get_basename();
+    };
+    paging.add(Gio::File::create_for_path("/tmp/b.jpg"));
+    paging.add(Gio::File::create_for_path("/tmp/d.jpg"));
+    if (paging.getPicts().size() != 5u
+     || front() != "c.jpg") {
+        std::cout << "paging_test add expected c.jpg got " << front() << std::endl;
+        return false;
+    }
+    paging.remove(Gio::File::create_for_path("/tmp/a.jpg"));
+    if (paging.getPicts().size() != 4u
+     || front() != "c.jpg") {
+        std::cout << "paging_test remove expected c.jpg got " << front() << std::endl;
+        return false;
+    }
+    paging.rename(Gio::File::create_for_path("/tmp/c.jpg"), Gio::File::create_for_path("/tmp/f.jpg"));
+    if (front() != "f.jpg"
+     || paging.getPicts()[2]->get_basename() != "e.jpg") {
+        std::cout << "paging_test rename expected f.jpg got " << front() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool
+paging_front_test()
+{
+    std::vector<Glib::RefPtr<Gio::File>> picts;
+    for (auto name : {"b.jpg", "d.jpg", "f.jpg"}) {
+        picts.push_back(Gio::File::create_for_path(Glib::build_filename("/tmp", name)));
+    }
+    PagingMode paging{2, picts};    // front f.jpg
+    auto front = [&] {
+        return paging.getFile(paging.get())->get_basename();
+    };
+    // adding a known file is ignored
+    if (paging.add(Gio::File::create_for_path("/tmp/d.jpg"))
+     || paging.size() != 3u) {
+        std::cout << "paging_front_test duplicate added size " << paging.size() << std::endl;
+        return false;
+    }
+    // unknown files are not removed
+    if (paging.remove(Gio::File::create_for_path("/tmp/x.jpg"))
+     || paging.size() != 3u) {
+        std::cout << "paging_front_test unknown removed size " << paging.size() << std::endl;
+        return false;
+    }
+    paging.add(Gio::File::create_for_path("/tmp/a.jpg"));
+    paging.add(Gio::File::create_for_path("/tmp/g.jpg"));
+    if (front() != "f.jpg"
+     || paging.getFile(0)->get_basename() != "a.jpg"
+     || paging.getFile(4)->get_basename() != "g.jpg") {
+        std::cout << "paging_front_test add expected f.jpg got " << front() << std::endl;
+        return false;
+    }
+    // renaming an other file keeps the front
+    paging.rename(Gio::File::create_for_path("/tmp/a.jpg"), Gio::File::create_for_path("/tmp/h.jpg"));
+    if (front() != "f.jpg"
+     || paging.getFile(4)->get_basename() != "h.jpg") {
+        std::cout << "paging_front_test rename expected f.jpg got " << front() << std::endl;
+        return false;
+    }
+    // removing the front shows the following
+    paging.remove(Gio::File::create_for_path("/tmp/f.jpg"));
+    if (front() != "g.jpg") {
+        std::cout << "paging_front_test remove expected g.jpg got " << front() << std::endl;
+        return false;
+    }
+    // removing the last front wraps to the first
+    paging.set(3);
+    paging.remove(Gio::File::create_for_path("/tmp/h.jpg"));
+    if (paging.get() != 0
+     || front() != "b.jpg") {
+        std::cout << "paging_front_test remove last expected b.jpg got " << front() << std::endl;
+        return false;
+    }
+    // the keys follow the changes, so the lookup still finds the entries
+    for (auto name : {"b.jpg", "d.jpg", "g.jpg"}) {
+        if (!paging.remove(Gio::File::create_for_path(Glib::build_filename("/tmp", name)))) {
+            std::cout << "paging_front_test remove " << name << " not found" << std::endl;
+            return false;
+        }
+    }
+    if (paging.size() != 0u) {
+        std::cout << "paging_front_test expected empty got " << paging.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+class TestDirMode
+: public DirMode
+{
+public:
+    using DirMode::DirMode;
+    using DirMode::on_dir_changed;
+};
+
+// files arriving by copy are accepted once their content is done,
+//   and removing the shown file moves to the neighbour
+static bool
+dir_mode_test()
+{
+    auto tmpDir = g_dir_make_tmp("dirmodeXXXXXX", nullptr);
+    if (!tmpDir) {
+        std::cout << "dir_mode_test no temporary dir" << std::endl;
+        return false;
+    }
+    auto dir = Gio::File::create_for_path(tmpDir);
+    g_free(tmpDir);
+    auto accept = [] (const Glib::RefPtr<Gio::File>& file) {    // as sniffing, empty is unknown
+        return file->query_exists()
+            && file->query_info(G_FILE_ATTRIBUTE_STANDARD_SIZE)->get_size() > 0;
+    };
+    std::string etag;
+    std::vector<Glib::RefPtr<Gio::File>> picts;
+    for (auto name : {"a.jpg", "b.jpg"}) {
+        auto file = dir->get_child(name);
+        file->replace_contents("a", "", etag);
+        picts.push_back(file);
+    }
+    TestDirMode dirMode{dir, picts, accept};
+    uint32_t frontChanged{};
+    dirMode.signal_front_changed().connect([&frontChanged] {
+        ++frontChanged;
+    });
+    auto copied = dir->get_child("c.jpg");
+    copied->create_file()->close();
+    dirMode.on_dir_changed(copied, Glib::RefPtr<Gio::File>(), Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CREATED);
+    bool created = dirMode.contains(copied);
+    copied->replace_contents("c", "", etag);
+    dirMode.on_dir_changed(copied, Glib::RefPtr<Gio::File>(), Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CHANGES_DONE_HINT);
+    if (created
+     || !dirMode.contains(copied)
+     || dirMode.size() != 3u) {
+        std::cout << "dir_mode_test expected c.jpg added when done got size " << dirMode.size() << std::endl;
+        return false;
+    }
+    dirMode.set(1);     // b.jpg
+    auto shown = dirMode.getFile(1);
+    shown->remove();
+    dirMode.on_dir_changed(shown, Glib::RefPtr<Gio::File>(), Gio::FileMonitorEvent::FILE_MONITOR_EVENT_DELETED);
+    auto front = dirMode.getFile(dirMode.get())->get_basename();
+    for (auto& file : dirMode.getPicts()) {
+        file->remove();
+    }
+    dir->remove();
+    if (frontChanged != 1u
+     || front != "c.jpg") {
+        std::cout << "dir_mode_test expected c.jpg shown got " << front << " changed " << frontChanged << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool
+executor_test()
+{
+    psc::util::Executor executor{1};
+    std::promise<void> blocker;
+    auto blocked = blocker.get_future().share();
+    // occupy the only thread, so the following get queued
+    auto first = executor.submit(psc::util::Priority::Visible, [blocked] {
+        blocked.wait();
+    });
+    std::mutex mutex;
+    std::vector<psc::util::Priority> order;
+    std::vector<std::future<void>> futures;
+    for (auto priority : {psc::util::Priority::Prefetch
+                        , psc::util::Priority::Histogram
+                        , psc::util::Priority::Visible}) {
+        futures.push_back(executor.submit(priority, [&, priority] {
+            std::lock_guard<std::mutex> lock{mutex};
+            order.push_back(priority);
+        }));
+    }
+    blocker.set_value();
+    for (auto& future : futures) {
+        future.get();
+    }
+    if (order != std::vector<psc::util::Priority>{psc::util::Priority::Visible
+                                                , psc::util::Priority::Histogram
+                                                , psc::util::Priority::Prefetch}) {
+        std::cout << "executor_test expected order by priority" << std::endl;
+        return false;
+    }
+    auto result = executor.submit(psc::util::Priority::Background, [] {
+        return 42;
+    });
+    auto metrics = executor.getMetrics();
+    if (result.get() != 42
+     || metrics.threads != 1u
+     || metrics.maxQueued < 3u) {
+        std::cout << "executor_test unexpected metrics queued " << metrics.maxQueued << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool
+parallel_test()
+{
+    std::vector<uint32_t> values(100003u);
+    psc::util::parallel_for(0u, values.size(), 1000u, [&] (size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            values[i] = static_cast<uint32_t>(i);
+        }
+    });
+    auto sum = psc::util::parallel_reduce(0u, values.size(), 777u, uint64_t{0}
+        , [&] (size_t lo, size_t hi, uint64_t& partial) {
+            for (size_t i = lo; i < hi; ++i) {
+                partial += values[i];
+            }
+        }
+        , [] (uint64_t& result, const uint64_t& partial) {
+            result += partial;
+        });
+    const uint64_t expected = static_cast<uint64_t>(values.size()) * (values.size() - 1u) / 2u;
+    if (sum != expected) {
+        std::cout << "parallel_test expected " << expected << " got " << sum << std::endl;
+        return false;
+    }
+    try {
+        psc::util::parallel_for(0u, 100u, 1u, [] (size_t lo, size_t hi) {
+            if (lo == 50u) {
+                throw std::runtime_error("expected");
+            }
+        });
+        std::cout << "parallel_test expected exception" << std::endl;
+        return false;
+    }
+    catch (const std::runtime_error&) {
+    }
+    return true;
+}
+
+static bool
+queue_test()
+{
+    TQueueConcurrent<int> queue{2u};
+    if (!queue.try_push(0)
+     || !queue.try_push(1)
+     || queue.try_push(2)) {
+        std::cout << "queue_test expected full after 2" << std::endl;
+        return false;
+    }
+    constexpr int COUNT{100};
+    std::thread producer([&] {
+        for (int i = 2; i < COUNT; ++i) {
+            queue.push(i);      // waits for room
+        }
+        queue.finish();
+    });
+    int expected{0};
+    bool ordered{true};
+    while (true) {
+        auto batch = queue.pop_batch(8u);
+        if (batch.empty()) {
+            break;
+        }
+        if (batch.size() > queue.capacity()) {
+            ordered = false;
+        }
+        for (auto val : batch) {
+            ordered &= val == expected;
+            ++expected;
+        }
+    }
+    producer.join();
+    if (!ordered
+     || expected != COUNT) {
+        std::cout << "queue_test expected " << COUNT << " got " << expected << std::endl;
+        return false;
+    }
+    if (queue.pop_for(std::chrono::milliseconds(10)).has_value()
+     || queue.push(COUNT)
+     || queue.push_back(COUNT)
+     || queue.emplace_back(COUNT)
+     || queue.emplace_front(COUNT)
+     || queue.size() != 0u) {
+        std::cout << "queue_test expected finished" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool
+map_test()
+{
+    TShardedMapConcurrent<uint32_t, uint32_t> map;
+    constexpr uint32_t KEYS{1000u};
+    std::atomic<uint32_t> computed{0u};
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < 4u; ++t) {
+        threads.emplace_back([&] {
+            for (uint32_t k = 0; k < KEYS; ++k) {
+                map.compute_if_absent(k, [&] (uint32_t key) {
+                    ++computed;
+                    return key * 2u;
+                });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (computed != KEYS
+     || map.size() != KEYS
+     || map.find(21u).value_or(0u) != 42u
+     || map.find(KEYS).has_value()) {
+        std::cout << "map_test expected " << KEYS << " computed got " << computed << std::endl;
+        return false;
+    }
+    if (map.insert_or_assign(21u, 0u)
+     || !map.insert_or_assign(KEYS, 0u)) {
+        std::cout << "map_test insert_or_assign unexpected result" << std::endl;
+        return false;
+    }
+    uint32_t visited{};
+    map.for_each([&visited] (uint32_t, uint32_t) {
+        ++visited;
+    });
+    if (visited != KEYS + 1u) {
+        std::cout << "map_test for_each visited " << visited << std::endl;
+        return false;
+    }
+    auto erased = map.erase_if([] (uint32_t key, uint32_t) {
+        return key % 2u == 1u;
+    });
+    if (erased != KEYS / 2u
+     || map.contains(21u)
+     || !map.erase(20u)
+     || map.size() != KEYS / 2u) {    // the even keys, KEYS added and 20 removed
+        std::cout << "map_test erase unexpected erased " << erased << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool
+vector_test()
+{
+    TSegmentedVectorConcurrent<uint32_t> vector;
+    constexpr uint32_t COUNT{10000u};
+    std::thread writer([&] {
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            vector.push_back(COUNT - i);
+        }
+    });
+    // read while appending, a snapshot has to stay consistent
+    bool consistent{true};
+    while (vector.size() < COUNT) {
+        auto snapshot = vector.snapshot();
+        uint32_t expected{COUNT};
+        for (auto val : snapshot) {
+            consistent &= val == expected;
+            --expected;
+        }
+    }
+    writer.join();
+    auto first = &vector.snapshot()[0];
+    std::vector<uint32_t> more{0u, COUNT + 1u};
+    vector.append(more.begin(), more.end());
+    if (!consistent
+     || first != &vector.snapshot()[0]
+     || vector[0] != COUNT
+     || vector[COUNT + 1u] != COUNT + 1u
+     || vector.size() != COUNT + 2u) {
+        std::cout << "vector_test expected consistent snapshots" << std::endl;
+        return false;
+    }
+    auto unsorted = vector.snapshot();
+    vector.sort(std::less<uint32_t>());
+    auto sorted = vector.snapshot();
+    if (!std::is_sorted(sorted.begin(), sorted.end())
+     || sorted.size() != COUNT + 2u
+     || unsorted[0] != COUNT) {
+        std::cout << "vector_test expected sorted " << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool
+pipeline_test()
+{
+    constexpr uint64_t COUNT{1000u};
+    std::atomic<uint64_t> sum{};
+    auto pipeline = psc::util::Pipeline::source<uint64_t>("count", [] (psc::util::PipelineEmitter<uint64_t>& emit) {
+            for (uint64_t i = 1; i <= COUNT; ++i) {
+                emit(i);
+            }
+        }, 4u)
+        .map("square", [] (uint64_t&& val) {
+            return val * val;
+        }, 3u, 4u)
+        .then<uint64_t>("even", [] (uint64_t&& val, psc::util::PipelineEmitter<uint64_t>& emit) {
+            if (val % 2u == 0u) {
+                emit(val);
+            }
+        })
+        .sink("sum", [&sum] (uint64_t&& val) {
+            sum += val;
+        });
+    pipeline->wait();
+    uint64_t expected{};
+    for (uint64_t i = 2; i <= COUNT; i += 2u) {
+        expected += i * i;
+    }
+    auto metrics = pipeline->getMetrics();
+    if (sum != expected
+     || metrics.size() != 4u
+     || metrics[0].emitted != COUNT
+     || metrics[1].processed != COUNT
+     || metrics[2].emitted != COUNT / 2u
+     || metrics[3].processed != COUNT / 2u) {
+        std::cout << "pipeline_test expected sum " << expected << " got " << sum << std::endl;
+        return false;
+    }
+    // an endless source has to stop on failure, and the failure is passed on
+    auto failing = psc::util::Pipeline::source<int>("endless", [] (psc::util::PipelineEmitter<int>& emit) {
+            int i{};
+            while (emit(i++)) {
+            }
+        })
+        .sink("fail", [] (int&& val) {
+            if (val == 100) {
+                throw std::runtime_error("expected failure");
+            }
+        });
+    try {
+        failing->wait();
+        std::cout << "pipeline_test expected exception" << std::endl;
+        return false;
+    }
+    catch (const std::runtime_error&) {
+    }
+    return failing->isCancelled();
+}
+// give access to the synchronous parts
+class TestThumbnailService
+: public ThumbnailService
+{
+public:
+    TestThumbnailService()
+    : ThumbnailService(ThumbnailSize::Normal, 1u, 2u)
+    {
+    }
+    using ThumbnailService::loadThumbnail;
+    using ThumbnailService::readValid;
+    using ThumbnailService::cache;
+};
+
+static Glib::RefPtr<Gio::File>
+createImage(const std::string& dir, const std::string& name, int width, int height)
+{
+    auto image = Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, false, 8, width, height);
+    image->fill(0x4080c0ffu);
+    auto path = Glib::build_filename(dir, name);
+    image->save(path, "png");
+    return Gio::File::create_for_path(path);
+}
+
+static bool
+thumbnail_test()
+{
+    // keep the users cache untouched, works as long as it was not queried before
+    auto tmpDir = g_dir_make_tmp("thumbXXXXXX", nullptr);
+    if (!tmpDir) {
+        std::cout << "thumbnail_test no temporary dir" << std::endl;
+        return false;
+    }
+    std::string tmp{tmpDir};
+    g_free(tmpDir);
+    Glib::setenv("XDG_CACHE_HOME", Glib::build_filename(tmp, "cache"), true);
+    TestThumbnailService service;
+    auto file = createImage(tmp, "large.png", 400, 200);
+    auto request = std::make_shared<ThumbnailRequest>();
+    request->file = file;
+    request->uri = file->get_uri();
+    auto path = ThumbnailService::getThumbnailPath(request->uri, ThumbnailSize::Normal);
+    auto mtime = file->query_info("time::modified")->get_attribute_uint64("time::modified");
+    if (service.readValid(path, request->uri, mtime)) {
+        std::cout << "thumbnail_test expected miss for " << path << std::endl;
+        return false;
+    }
+    auto pixbuf = service.loadThumbnail(request);
+    if (!pixbuf
+     || pixbuf->get_width() != 128
+     || pixbuf->get_height() != 64) {
+        std::cout << "thumbnail_test expected 128x64 thumbnail" << std::endl;
+        return false;
+    }
+    if (!service.readValid(path, request->uri, mtime)) {
+        std::cout << "thumbnail_test expected hit for " << path << std::endl;
+        return false;
+    }
+    // a modified file invalidates the thumbnail, until it is recreated
+    file->set_attribute_uint64("time::modified", mtime + 10u);
+    auto modified = file->query_info("time::modified")->get_attribute_uint64("time::modified");
+    if (modified == mtime
+     || service.readValid(path, request->uri, modified)) {
+        std::cout << "thumbnail_test expected miss for modified " << modified << std::endl;
+        return false;
+    }
+    service.loadThumbnail(request);
+    if (!service.readValid(path, request->uri, modified)) {
+        std::cout << "thumbnail_test expected hit for recreated " << modified << std::endl;
+        return false;
+    }
+    // small images are not scaled up
+    auto small = createImage(tmp, "small.png", 40, 30);
+    auto smallRequest = std::make_shared<ThumbnailRequest>();
+    smallRequest->file = small;
+    smallRequest->uri = small->get_uri();
+    auto smallPixbuf = service.loadThumbnail(smallRequest);
+    if (!smallPixbuf
+     || smallPixbuf->get_width() != 40
+     || smallPixbuf->get_height() != 30) {
+        std::cout << "thumbnail_test expected small 40x30 thumbnail" << std::endl;
+        return false;
+    }
+    // memory cache keeps the recently used
+    auto other = Gio::File::create_for_path(Glib::build_filename(tmp, "other.png"));
+    service.cache(request->uri, pixbuf);
+    service.cache(smallRequest->uri, smallPixbuf);
+    service.lookup(file);       // use, so small is the oldest
+    service.cache(other->get_uri(), pixbuf);
+    if (service.lookup(file) != pixbuf
+     || service.lookup(small)
+     || service.lookup(other) != pixbuf) {
+        std::cout << "thumbnail_test expected small evicted" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool
+navigation_test()
+{
+    Gtk::Main::init_gtkmm_internals();     // for the model, no display needed
+    std::vector<Glib::RefPtr<Gio::File>> picts;
+    for (auto name : {"a.jpg", "Ab.png", "b.jpg", "cab.jpg", "d.jpg"}) {
+        picts.push_back(Gio::File::create_for_path(Glib::build_filename("/tmp", name)));
+    }
+    PagingMode paging{0, picts};
+    auto all = PagingListModel::create(&paging);
+    if (all->getRowCount() != 5
+     || all->getRow(3) != 3) {
+        std::cout << "navigation_test expected 5 rows got " << all->getRowCount() << std::endl;
+        return false;
+    }
+    auto filtered = PagingListModel::create(&paging, "A");
+    if (filtered->getRowCount() != 3
+     || filtered->getRow(2) != -1) {
+        std::cout << "navigation_test expected 3 rows for a got " << filtered->getRowCount() << std::endl;
+        return false;
+    }
+    // narrowed from the previous rows, same as a full scan
+    auto narrowed = PagingListModel::create(&paging, "aB", filtered);
+    auto full = PagingListModel::create(&paging, "ab");
+    if (narrowed->getRowCount() != 2
+     || full->getRowCount() != 2
+     || narrowed->getRow(1) != 0
+     || narrowed->getRow(3) != 1
+     || full->getRow(3) != 1) {
+        std::cout << "navigation_test expected 2 rows for ab got " << narrowed->getRowCount() << std::endl;
+        return false;
+    }
+    Gtk::TreeModel::Path path;
+    path.push_back(1);
+    if (narrowed->getIndex(path) != 3) {
+        std::cout << "navigation_test expected index 3 got " << narrowed->getIndex(path) << std::endl;
+        return false;
+    }
+    auto iter = narrowed->children().begin();
+    Glib::ustring name = (*iter)[PagingListModel::m_columns.m_name];
+    if (name != "Ab.png") {
+        std::cout << "navigation_test expected Ab.png got " << name << std::endl;
+        return false;
+    }
+    // a shorter filter is not narrowed
+    auto widened = PagingListModel::create(&paging, "b", narrowed);
+    if (widened->getRowCount() != 3) {
+        std::cout << "navigation_test expected 3 rows for b got " << widened->getRowCount() << std::endl;
+        return false;
+    }
+    path[0] = 5;
+    if (widened->getIndex(path) != -1) {
+        std::cout << "navigation_test expected -1 for out of range" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool
+classify_test()
+{
+    auto& formats = PixbufFormats::get();
+    struct Case {
+        const char* name;
+        const char* fastContentType;
+        Readable expected;
+    };
+    // png is always built into gdk-pixbuf
+    for (auto& test : {Case{"x.png", "", Readable::Yes}
+                     , Case{"x.PNG", "", Readable::Yes}
+                     , Case{"x.dat", "image/png", Readable::Yes}
+                     , Case{"x.txt", "text/plain", Readable::No}
+                     , Case{"x", "", Readable::Unknown}
+                     , Case{"x", "application/octet-stream", Readable::Unknown}}) {
+        if (formats.classify(test.name, test.fastContentType) != test.expected) {
+            std::cout << "classify_test unexpected result for " << test.name
+                      << " " << test.fastContentType << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// run the main loop until quit or the timeout
+static void
+runLoop(const Glib::RefPtr<Glib::MainLoop>& loop, unsigned int timeoutMs)
+{
+    auto timeout = Glib::signal_timeout().connect(
+        [loop] {
+            loop->quit();
+            return false;
+        }, timeoutMs);
+    loop->run();
+    timeout.disconnect();
+}
+
+static bool
+image_list_test()
+{
+    Gtk::Main::init_gtkmm_internals();
+    std::string path;
+    int fd = Glib::file_open_tmp(path, "imagelistXXXXXX");
+    close(fd);
+    auto file = Gio::File::create_for_path(path);
+    auto other = Gio::File::create_for_path(Glib::path_get_dirname(path));
+    auto list = ImageList::create();
+    auto loop = Glib::MainLoop::create();
+    int otherCalls{0}, fileCalls{0};
+    // a new query cancels the pending
+    list->queryAsync(other,
+        [&] (const Glib::RefPtr<Gio::File>& queried, const Glib::RefPtr<Gio::FileInfo>& info) {
+            ++otherCalls;
+        });
+    list->queryAsync(file,
+        [&] (const Glib::RefPtr<Gio::File>& queried, const Glib::RefPtr<Gio::FileInfo>& info) {
+            ++fileCalls;
+            list->fillList(queried, info);
+            loop->quit();
+        });
+    runLoop(loop, 5000u);
+    if (otherCalls != 0
+     || fileCalls != 1) {
+        std::cout << "image_list_test expected only latest got " << otherCalls << " " << fileCalls << std::endl;
+        return false;
+    }
+    auto rows = list->children();
+    if (rows.empty()) {
+        std::cout << "image_list_test expected file infos" << std::endl;
+        return false;
+    }
+    Glib::ustring name = (*rows.begin())[ImageList::m_variableColumns.m_name];
+    if (name != "File") {
+        std::cout << "image_list_test expected File got " << name << std::endl;
+        return false;
+    }
+    // a cancelled query is not delivered
+    list->queryAsync(file,
+        [&] (const Glib::RefPtr<Gio::File>& queried, const Glib::RefPtr<Gio::FileInfo>& info) {
+            ++fileCalls;
+        });
+    list->cancelQuery();
+    runLoop(loop, 200u);
+    if (fileCalls != 1) {
+        std::cout << "image_list_test expected cancelled got " << fileCalls << std::endl;
+        return false;
+    }
+    Gio::File::create_for_path(path)->remove();
+    // the view requires a display
+    if (!gtk_init_check(nullptr, nullptr)) {
+        std::cout << "image_list_test no display, skipping view" << std::endl;
+        return true;
+    }
+    auto builder = Gtk::Builder::create_from_string(
+        "<interface><object class=\"GtkTreeView\" id=\"view\"/></interface>");
+    auto view = Glib::RefPtr<Gtk::TreeView>::cast_dynamic(builder->get_object("view"));
+    view->set_model(list);
+    bool detached{false};
+    auto count = list->children().size();
+    ImageList::fillDetached(view, list, [&] {
+        detached = !view->get_model();
+        list->appendList("Name", "value");
+    });
+    if (!detached
+     || Glib::RefPtr<ImageList>::cast_dynamic(view->get_model()) != list
+     || list->children().size() != count + 1) {
+        std::cout << "image_list_test expected fill while detached" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 int main(int argc, char** argv)
 {
     setlocale(LC_ALL, "en");      // make locale dependent, and make glib accept u8 const !!!
@@ -100,6 +829,45 @@ int main(int argc, char** argv)
     if (!date_test()) {
         return 3;
     }
+    if (!paging_test()) {
+        return 4;
+    }
+    if (!executor_test()) {
+        return 5;
+    }
+    if (!parallel_test()) {
+        return 6;
+    }
+    if (!queue_test()) {
+        return 7;
+    }
+    if (!map_test()) {
+        return 8;
+    }
+    if (!vector_test()) {
+        return 9;
+    }
+    if (!pipeline_test()) {
+        return 10;
+    }
+    if (!paging_front_test()) {
+        return 11;
+    }
+    if (!dir_mode_test()) {
+        return 12;
+    }
+    if (!thumbnail_test()) {
+        return 13;
+    }
+    if (!navigation_test()) {
+        return 14;
+    }
+    if (!classify_test()) {
+        return 15;
+    }
+    if (!image_list_test()) {
+        return 16;
+    }
 
     return 0;
 }